@@ -0,0 +1,72 @@
+#ifndef CGROUP_ENERGY_HH
+#define CGROUP_ENERGY_HH
+
+#include <time.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#define MAX_CGROUPS 16
+
+namespace cgroup_energy
+{
+    // This struct contains the CPU usage of each monitored cgroup along with the time it was read
+    struct CgroupAux
+    {
+        // Timestamp when this struct was last updated
+        struct timespec time;
+        // usage_usec from each cgroup's cpu.stat
+        // This assumes a maximum of 16 cgroups, but may be increased or decreased as needed
+        unsigned long long usage_usec[MAX_CGROUPS];
+    };
+
+    // Stores the package energy and average power attributed to each cgroup during the last
+    // measurement interval and the total energy attributed to it, plus the energy not
+    // attributed to any monitored cgroup (idle, kernel and other processes)
+    struct CgroupData
+    {
+        double energy[MAX_CGROUPS]{};
+        double power[MAX_CGROUPS]{};
+        double total_energy[MAX_CGROUPS]{};
+        double unattributed_energy{0};
+        double unattributed_power{0};
+    };
+
+    // Root of the cgroup v2 hierarchy, /sys/fs/cgroup by default
+    extern std::filesystem::path cgroup_root;
+    // Monitored cgroups, relative to cgroup_root
+    extern std::vector<std::string> cgroups;
+
+    /*
+    Read cgroups from a different root, e.g. a directory with synthetic cpu.stat files
+    */
+    void set_cgroup_root(std::string root);
+
+    /*
+    Add a cgroup to the monitored set, as a path relative to the cgroup root. Monitored cgroups
+    must not overlap: a parent's CPU usage already includes its children's, so a cgroup nested in
+    another monitored one, or the same one added twice, is rejected. Returns a non-zero value if
+    the cgroup is rejected or MAX_CGROUPS cgroups are already monitored
+    */
+    int add_cgroup(std::string cgroup);
+
+    /*
+    Returns the usage_usec of the specified cgroup's cpu.stat, or 0 if it can't be read
+    */
+    unsigned long long get_cgroup_usage(const std::string &cgroup);
+
+    /*
+    Updates the input CgroupAux struct with the current CPU usage of every monitored cgroup
+    */
+    void update_cgroup_usage(CgroupAux &data);
+
+    /*
+    Splits the package energy consumed between two CgroupAux measurements proportionally to the
+    share of the machine's CPU time (num_cpus times the interval) used by each cgroup. Energy
+    not attributed to any cgroup is reported separately
+    */
+    void update_cgroup_data(CgroupData &output_data, const CgroupAux &previous_data, const CgroupAux &current_data,
+                            double energy, int num_cpus);
+}
+
+#endif
\ No newline at end of file
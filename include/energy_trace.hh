@@ -0,0 +1,66 @@
+#ifndef ENERGY_TRACE_HH
+#define ENERGY_TRACE_HH
+
+#include "rapl_utils.hh"
+#include "nvml_utils.hh"
+#include "work_counter.hh"
+
+#include <filesystem>
+
+/*
+Records the raw per-node and per-device readings of every source, as they are taken, so that
+they can be fed back through the same processing and output pipeline on any machine.
+
+The trace is a text file. The header stores the topology needed to process the readings
+(NUMA nodes, counter wraparound values, number of GPUs), the offset between CLOCK_REALTIME
+and CLOCK_MONOTONIC during the recording and which sources were measured,
+followed by one line per reading:
+    <source> <seconds> <nanoseconds> <value> <value> ...
+*/
+namespace energy_trace
+{
+    extern bool recording;
+    extern bool replaying;
+    // Offset from CLOCK_REALTIME to CLOCK_MONOTONIC in microseconds on the recording run,
+    // set by start_replay()
+    extern double clock_offset_us;
+
+    /*
+    Start recording into the specified file. Must be called after the sources have been initialized,
+    as the header stores the topology
+    */
+    void start_recording(const std::filesystem::path &filename, bool thermal, bool work);
+    void stop_recording();
+
+    void record_cpu_energy(const rapl_utils::EnergyAux &data);
+    void record_gpu_energy(const nvml_utils::EnergyAux &data);
+    void record_thermal(const rapl_utils::ThermalAux &data);
+    void record_work(const work_counter::WorkAux &data);
+
+    /*
+    Open a trace for replay. Restores the topology stored in the header into rapl_utils and
+    nvml_utils, and reports which optional sources were recorded. Returns a non-zero value if
+    the file can't be read or its topology doesn't fit the EnergyAux structs
+    */
+    int start_replay(const std::filesystem::path &filename, bool &thermal, bool &work);
+    /*
+    Close the trace and restore the live topology that was replaced by start_replay()
+    */
+    void stop_replay();
+
+    /*
+    Fill the input struct with the next recorded reading of the corresponding source. Return false
+    once the trace is exhausted or the next reading belongs to a different source
+    */
+    bool replay_cpu_energy(rapl_utils::EnergyAux &data);
+    bool replay_gpu_energy(nvml_utils::EnergyAux &data);
+    bool replay_thermal(rapl_utils::ThermalAux &data);
+    bool replay_work(work_counter::WorkAux &data);
+
+    /*
+    Returns the recorded time in seconds between the last replayed reading and the next one
+    */
+    double time_to_next_reading();
+}
+
+#endif
\ No newline at end of file
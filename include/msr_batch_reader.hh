@@ -0,0 +1,34 @@
+#ifndef MSR_BATCH_READER_HH
+#define MSR_BATCH_READER_HH
+
+// Batched reads of one MSR across many cores, for callers that sample per-core registers such
+// as AMD's per-core energy counter. The monitoring loop only reads one core per NUMA node and
+// does not use it, see node_reader.hh for reading nodes in parallel
+
+namespace rapl_utils
+{
+    // Whether batches are read through io_uring, false if it is unavailable and
+    // batches fall back to one pread per core
+    extern bool msr_batch_uring;
+
+    /*
+    Prepare to read the same MSR on the specified cores as a batch. Caches the MSR file of
+    each core and sets up an io_uring instance able to hold the whole batch. Falls back to
+    plain preads if io_uring can't be set up. Must be called before reading from several threads
+    */
+    void init_msr_batch(const int *cores, int count);
+
+    /*
+    Release the io_uring instance. The cached MSR files are closed by close_msr_files()
+    */
+    void close_msr_batch();
+
+    /*
+    Read the MSR at the specified address on every core passed to init_msr_batch(), storing
+    the raw values in the same order. With io_uring, all reads are submitted and reaped with
+    a single system call
+    */
+    void read_msr_batch(unsigned int address, unsigned long long *values);
+} // namespace rapl_utils
+
+#endif
\ No newline at end of file
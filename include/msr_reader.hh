@@ -3,9 +3,16 @@
 
 #include <stdio.h>
 #include <unistd.h>
+#include <string>
+#include <vector>
 
 namespace rapl_utils
 {
+    // Cached MSR files indexed by core, nullptr for cores without a cached file
+    extern std::vector<FILE *> msr_files;
+    // Directory containing a [core]/msr file per core
+    extern std::string msr_dir;
+
     /*
     Returns an open file for the MSRs of the specified core
 
@@ -14,30 +21,41 @@ namespace rapl_utils
     FILE *open_msr(int core);
 
     /*
-    Returns the value of the MSR at the specified address in the specified MSR file
+    Read the MSR files from a different directory, laid out as [dir]/[core]/msr. Each file
+    holds the MSRs of a core at their byte offsets, so regular files can stand in for the
+    msr driver when running without MSR access
+    */
+    void set_msr_dir(std::string dir);
+
+    /*
+    Returns the value of the MSR at the specified address in the specified MSR file,
+    or 0 if the MSR can't be read
     */
     unsigned long long read_msr(FILE *file, unsigned int address);
 
     /*
-    Reads all fields from the msr at msr_address and stores their values in the
-    msr_values array
-
-    msr_address: The offset in bytes from the start of the MSR file to the beginning
-    of the MSR msr_numfields: The number of values to be extracted from the MSR
-    msr_offsets: An array containing the offset in bits from the start of the MSR to
-    each of the fields msr_sizes: An array containing the size in bits of each field
-    msr_values: The array in which the values of each field will be stored.
+    Returns whether the MSR at the specified address can be read on the specified core.
+    Used to detect registers that are not implemented by this CPU
+    */
+    bool probe_msr(int core, unsigned int address);
+
+    /*
+    Returns the raw value of the MSR at the specified address of the specified core. Uses the
+    core's cached MSR file if there is one, otherwise opens and closes it. Fields are extracted
+    with the MsrField descriptors in rapl_const.hh
+    */
+    unsigned long long read_msr(int core, unsigned int address);
+
+    /*
+    Opens the MSR file of the specified core and keeps it open for subsequent reads.
+    Not thread-safe, all files should be cached before reading from several threads
     */
-    void read_msr_fields(int core, const unsigned int msr_address,
-                         const unsigned int msr_numfields,
-                         const unsigned int *msr_offsets,
-                         const unsigned int *msr_sizes,
-                         unsigned long long *msr_values);
+    void cache_msr_file(int core);
 
     /*
-    Returns a variable with the last "size" least significant bits set to 1
+    Closes all cached MSR files
     */
-    unsigned long long get_mask(unsigned int size);
+    void close_msr_files();
 } // namespace rapl_utils
 
 #endif
\ No newline at end of file
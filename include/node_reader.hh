@@ -0,0 +1,34 @@
+#ifndef NODE_READER_HH
+#define NODE_READER_HH
+
+#include "rapl_utils.hh"
+
+namespace rapl_utils
+{
+    /*
+    Launches one reader thread per NUMA node, pinned to the first core of that node, so
+    that each package's MSRs are read locally and all nodes are read in parallel.
+    Waking the readers costs a few microseconds per sample, so this only pays off when remote MSR
+    reads are slower than that, see tests/bench_node_reader.cc. Must be called after init()
+    */
+    void start_node_readers();
+
+    /*
+    Stops and joins the reader threads
+    */
+    void stop_node_readers();
+
+    /*
+    Same as update_aux_data(), but each node is read by its own reader thread. Blocks until all
+    nodes have been read. Concurrent callers are serialized, each gets a complete snapshot
+    */
+    void update_aux_data_parallel(EnergyAux &data, int domain);
+
+    /*
+    Updates the input EnergyAux struct with the last per-node energy readings of RAPL's Package domain
+    in Joules, reading all nodes in parallel
+    */
+    void update_package_energy_parallel(EnergyAux &data);
+} // namespace rapl_utils
+
+#endif
\ No newline at end of file
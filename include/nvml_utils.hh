@@ -3,6 +3,7 @@
 
 #include <time.h>
 #include <memory>
+#include <vector>
 #include <nvml.h>
 
 #define MAX_GPUS 4
@@ -28,8 +29,19 @@ namespace nvml_utils
         double total_energy{0};
     };
 
+    // A power sample taken by the driver
+    struct PowerSample
+    {
+        // Microseconds since the epoch, as reported by NVML
+        unsigned long long timestamp;
+        // Watts
+        double power;
+    };
+
     extern std::unique_ptr<nvmlDevice_t[]> device_handles;
     extern unsigned int num_GPUs;
+    // Timestamp of the last power sample retrieved from each GPU
+    extern std::unique_ptr<unsigned long long[]> last_sample_timestamp;
 
     /*
     Initialize the number of GPUs in the machine and get their nvml handles
@@ -46,6 +58,18 @@ namespace nvml_utils
     usage and energy consumption, and updates the total energy consumption measured in this EnergyData struct
     */
     void update_energy_data(EnergyData &output_data, const EnergyAux &previous_data, const EnergyAux &current_data);
+
+    /*
+    Only retrieve power samples taken from now on, discarding those kept by the driver
+    */
+    void reset_power_samples();
+
+    /*
+    Retrieves the power samples taken by the driver for the specified GPU since the last call, which
+    has a much higher resolution than polling the energy counter. Returns NVML_ERROR_NOT_SUPPORTED if
+    the device does not keep power samples, in which case only the energy counter can be used
+    */
+    nvmlReturn_t get_power_samples(unsigned int gpu, std::vector<PowerSample> &samples);
 }
 
 #endif
\ No newline at end of file
@@ -1,6 +1,7 @@
 #ifndef POWER_METER_HH
 #define POWER_METER_HH
 
+#include <atomic>
 #include <thread>
 #include <filesystem>
 #include <fstream>
@@ -11,20 +12,95 @@ namespace power_meter
     extern bool do_monitoring;
     extern std::thread monitoring_thread; // Default-constructed thread, will get replaced when we launch an actual thread
 
+    // Whether to also measure package throttling and temperature (Intel only)
+    extern bool thermal_monitoring;
+    // Whether to report energy efficiency per application operation, see work_counter.hh
+    extern bool work_monitoring;
+    // Whether to read each NUMA node from a reader thread pinned to that node, see node_reader.hh
+    extern bool parallel_node_reading;
+    // Whether to harvest the power samples buffered by the NVML driver, see set_gpu_power_samples()
+    extern bool gpu_power_samples;
+    // Replay speed relative to the recorded run, 0 replays as fast as possible
+    extern double replay_speedup;
+
+    // Adaptive sampling: the loop samples every burst_interval_ms after a power transient or an
+    // application trigger, and decays back to the base sampling interval while power is steady
+    extern bool adaptive_sampling;
+    extern unsigned int burst_interval_ms;
+    // Change in total CPU + GPU power between consecutive samples that starts a burst, in Watts
+    extern double burst_threshold_watts;
+    // Set by trigger_burst(), consumed by the monitoring loop
+    extern std::atomic<bool> burst_triggered;
+
+    // Monitoring thread placement: core to pin it to (-1 to let it run anywhere), and
+    // scheduling policy and priority, as passed to pthread_setschedparam
+    extern int monitoring_core;
+    extern int monitoring_sched_policy;
+    extern int monitoring_sched_priority;
+
+    // How late the monitoring thread wakes up compared to the requested sampling interval
+    struct WakeupStats
+    {
+        unsigned long long samples{0};
+        double total_latency_us{0};
+        double max_latency_us{0};
+    };
+    extern WakeupStats wakeup_stats;
+
     // Output
     extern std::filesystem::path output_dir;
     extern std::filesystem::path cpu_out_filename;
     extern std::filesystem::path gpu_out_filename;
+    extern std::filesystem::path gpu_samples_out_filename;
+    extern std::filesystem::path cgroups_out_filename;
+    // Trace of raw readings, not recorded if empty
+    extern std::filesystem::path record_filename;
+    // Chrome JSON trace with power counter tracks, not exported if empty
+    extern std::filesystem::path chrome_trace_filename;
     extern std::ofstream cpu_out;
     extern std::ofstream gpu_out;
+    extern std::ofstream gpu_samples_out;
+    extern std::ofstream cgroups_out;
+
+    /*
+    Initialize the CPU and GPU sources once, caching the topology, the MSR files and the NVML
+    handles. Shared by the monitoring loop and the sessions in session.hh. Later calls return
+    immediately. Returns a non-zero value on error
+    */
+    int init();
 
     /*
-    Launch a thread that will take measurements in the background
+    Release the cached MSR files and shut down NVML. Stops the monitoring loop first if it is
+    running. No session may be started or stopped during or after this call, until init() is
+    called again
+    */
+    void shutdown();
+
+    /*
+    Launch a thread that will take measurements in the background. Initializes the sources
+    through init() if needed and creates the output directory, nothing is launched if either fails
     */
     void launch_monitoring_loop(unsigned int sampling_interval_ms);
 
+    /*
+    Stop the monitoring thread. The sources stay initialized, call shutdown() to release them
+    */
     void stop_monitoring_loop();
 
+    /*
+    Feed a trace recorded with set_record_filename() through the same processing and output as the
+    monitoring loop. Runs on the calling thread and returns once the trace is exhausted. Refuses to
+    run while a monitoring loop is running.
+    speedup: Replay speed relative to the recorded run, 0 replays as fast as possible
+    */
+    void replay_trace(std::string trace_filename, double speedup = 0);
+
+    /*
+    Entry point of the monitoring thread. Applies the configured affinity and scheduling,
+    opens the output files and runs the monitoring loop
+    */
+    void monitoring_thread_main(unsigned int sampling_interval_ms);
+
     /*
     Power measurement loop, intended to run on a separate thread
     */
@@ -36,6 +112,83 @@ namespace power_meter
     void set_output_dir(std::string dir);
     void set_cpu_out_filename(std::string filename);
     void set_gpu_out_filename(std::string filename);
+
+    /*
+    Record every raw reading into this file in the output directory, so that the run can
+    be replayed with replay_trace(). Must be called before launching the monitoring loop
+    */
+    void set_record_filename(std::string filename);
+
+    /*
+    Export per-node CPU power and per-device GPU power into this file in the output directory,
+    as counter tracks in the Chrome JSON trace format. Must be called before launching the
+    monitoring loop
+    */
+    void set_chrome_trace_filename(std::string filename);
+
+    /*
+    Enable or disable harvesting the GPU power samples buffered by the NVML driver on each
+    interval. Samples are written with their timestamp to the GPU samples file and to the Chrome
+    trace, if exported. GPUs that don't keep power samples are only polled through their energy
+    counter, the setting itself is kept for later loops.
+    Must be called before launching the monitoring loop
+    */
+    void set_gpu_power_samples(bool enable);
+    void set_gpu_samples_out_filename(std::string filename);
+
+    /*
+    Output file for the per-cgroup energy attribution. Attribution is enabled by adding cgroups
+    with cgroup_energy::add_cgroup() before launching the monitoring loop
+    */
+    void set_cgroups_out_filename(std::string filename);
+
+    /*
+    Enable or disable adaptive sampling. The sampling interval passed to launch_monitoring_loop()
+    becomes the base interval, and the loop switches to burst_interval_ms whenever total power
+    changes by more than threshold_watts between samples or trigger_burst() is called. Adds the
+    effective interval of each sample to the output. Must be called before launching the
+    monitoring loop
+    */
+    void set_adaptive_sampling(bool enable, unsigned int burst_interval_ms = 1, double threshold_watts = 0);
+
+    /*
+    Pin the monitoring thread to a core, e.g. a housekeeping core not used by the application.
+    Its output buffers are allocated on that core's NUMA node. -1 lets it run on any core.
+    Must be called before launching the monitoring loop
+    */
+    void set_monitoring_affinity(int core);
+
+    /*
+    Set the scheduling policy (e.g. SCHED_FIFO) and priority of the monitoring thread to reduce
+    wakeup jitter. Falls back to the default policy with a warning if not permitted. Must be
+    called before launching the monitoring loop
+    */
+    void set_monitoring_scheduling(int policy, int priority);
+
+    /*
+    Request high-rate sampling starting from the next sample, e.g. when the application enters
+    a new phase. Safe to call from any thread
+    */
+    void trigger_burst();
+
+    /*
+    Enable or disable the throttling and thermal columns in the CPU output. Must be called
+    before launching the monitoring loop
+    */
+    void set_thermal_monitoring(bool enable);
+
+    /*
+    Enable or disable the work-normalized efficiency columns in the CPU and GPU output. The
+    application reports completed operations through work_counter::add_work(). Must be called
+    before launching the monitoring loop
+    */
+    void set_work_monitoring(bool enable);
+
+    /*
+    Enable or disable reading the energy of each NUMA node in parallel from a thread pinned
+    to that node. Must be called before launching the monitoring loop
+    */
+    void set_parallel_node_reading(bool enable);
 }
 
 #endif
\ No newline at end of file
@@ -5,52 +5,120 @@
 
 namespace rapl_utils
 {
-#define INTEL_MSR_RAPL_POWER_UNIT 0x606
-#define INTEL_MSR_RAPL_POWER_UNIT_NUMFIELDS 3
-    inline const char *INTEL_MSR_RAPL_POWER_UNIT_NAMES[] = {
-        "Power Units", "Energy Status Units", "Time Units"};
-    inline const unsigned int INTEL_MSR_RAPL_POWER_UNIT_SIZES[] = {4, 5, 4};
-    inline const unsigned int INTEL_MSR_RAPL_POWER_UNIT_OFFSETS[] = {0, 8, 16};
-
-#define AMD_MSR_RAPL_POWER_UNIT 0xC0010299
-#define AMD_MSR_RAPL_POWER_UNIT_NUMFIELDS 3
-    inline const char *AMD_MSR_RAPL_POWER_UNIT_NAMES[] = {
-        "Power Units", "Energy Status Units", "Time Units"};
-    inline const unsigned int AMD_MSR_RAPL_POWER_UNIT_SIZES[] = {4, 5, 4};
-    inline const unsigned int AMD_MSR_RAPL_POWER_UNIT_OFFSETS[] = {0, 8, 16};
-
-#define INTEL_MSR_PKG_ENERGY_STATUS 0x611
-#define INTEL_MSR_PKG_ENERGY_STATUS_NUMFIELDS 1
-    inline const char *INTEL_MSR_PKG_ENERGY_STATUS_NAMES[] = {"Total Energy Consumed"};
-    inline const unsigned int INTEL_MSR_PKG_ENERGY_STATUS_SIZES[] = {32};
-    inline const unsigned int INTEL_MSR_PKG_ENERGY_STATUS_OFFSETS[] = {0};
-
-#define AMD_MSR_PKG_ENERGY_STATUS 0xC001029B
-#define AMD_MSR_PKG_ENERGY_STATUS_NUMFIELDS 1
-    inline const char *AMD_MSR_PKG_ENERGY_STATUS_NAMES[] = {"Total Energy Consumed"};
-    inline const unsigned int AMD_MSR_PKG_ENERGY_STATUS_SIZES[] = {32};
-    inline const unsigned int AMD_MSR_PKG_ENERGY_STATUS_OFFSETS[] = {0};
-
-// The cores RAPL domain is called PP0 on Intel CPUs and Core on AMD
-#define INTEL_MSR_PP0_ENERGY_STATUS 0x639
-#define INTEL_MSR_PP0_ENERGY_STATUS_NUMFIELDS 1
-    inline const char *INTEL_MSR_PP0_ENERGY_STATUS_NAMES[] = {"Total Energy Consumed"};
-    inline const unsigned int INTEL_MSR_PP0_ENERGY_STATUS_SIZES[] = {32};
-    inline const unsigned int INTEL_MSR_PP0_ENERGY_STATUS_OFFSETS[] = {0};
-
-#define AMD_MSR_CORE_ENERGY_STATUS 0xC001029A
-#define AMD_MSR_CORE_ENERGY_STATUS_NUMFIELDS 1
-    inline const char *AMD_MSR_CORE_ENERGY_STATUS_NAMES[] = {"Total Energy Consumed"};
-    inline const unsigned int AMD_MSR_CORE_ENERGY_STATUS_SIZES[] = {32};
-    inline const unsigned int AMD_MSR_CORE_ENERGY_STATUS_OFFSETS[] = {0};
-
-#define INTEL_MSR_PKG_POWER_INFO 0x614
-#define INTEL_MSR_PKG_POWER_INFO_NUMFIELDS 4
-    inline const char *INTEL_MSR_PKG_POWER_INFO_NAMES[] = {
-        "Thermal Spec Power", "Minimum Power", "Maximum Power",
-        "Maximum Time Window"};
-    inline const unsigned int INTEL_MSR_PKG_POWER_INFO_SIZES[] = {15, 15, 15, 6};
-    inline const unsigned int INTEL_MSR_PKG_POWER_INFO_OFFSETS[] = {0, 16, 32, 48};
+    /*
+    Vendor ID enum
+    */
+    enum VENDOR_ID
+    {
+        INTEL,
+        AMD,
+        NUM_VENDORS
+    };
+
+    /*
+    Describes a field inside an MSR. Descriptors are constexpr, so the shift and mask
+    used to decode a field are compile-time constants
+    */
+    struct MsrField
+    {
+        const char *name;
+        // Offset in bits from the start of the MSR
+        unsigned int offset;
+        // Size in bits
+        unsigned int size;
+
+        /*
+        Returns a variable with the last "size" least significant bits set to 1
+        */
+        constexpr unsigned long long mask() const
+        {
+            return size >= 64 ? ~0ULL : (1ULL << size) - 1;
+        }
+
+        /*
+        Extracts the value of this field from the raw value of the MSR
+        */
+        constexpr unsigned long long decode(unsigned long long msr_value) const
+        {
+            return (msr_value >> offset) & mask();
+        }
+    };
+
+    /*
+    RAPL registers that have the same layout on Intel and AMD but live at different
+    addresses. The address for the running CPU is selected through RAPL_REGISTER_ADDRESSES
+    */
+    enum RAPL_REGISTER
+    {
+        RAPL_POWER_UNIT,
+        PKG_ENERGY_STATUS,
+        // The cores RAPL domain is called PP0 on Intel CPUs and Core on AMD
+        CORE_ENERGY_STATUS,
+        NUM_RAPL_REGISTERS
+    };
+
+    // Indexed by VENDOR_ID and RAPL_REGISTER
+    inline constexpr unsigned int RAPL_REGISTER_ADDRESSES[NUM_VENDORS][NUM_RAPL_REGISTERS] = {
+        // Intel: MSR_RAPL_POWER_UNIT, MSR_PKG_ENERGY_STATUS, MSR_PP0_ENERGY_STATUS
+        {0x606, 0x611, 0x639},
+        // AMD: MSR_RAPL_PWR_UNIT, MSR_PKG_ENERGY_STAT, MSR_CORE_ENERGY_STAT
+        {0xC0010299, 0xC001029B, 0xC001029A}};
+
+    namespace MSR_RAPL_POWER_UNIT
+    {
+        inline constexpr MsrField POWER_UNITS{"Power Units", 0, 4};
+        inline constexpr MsrField ENERGY_STATUS_UNITS{"Energy Status Units", 8, 5};
+        inline constexpr MsrField TIME_UNITS{"Time Units", 16, 4};
+    }
+
+    // Shared by the package and cores energy status registers
+    namespace MSR_ENERGY_STATUS
+    {
+        inline constexpr MsrField TOTAL_ENERGY_CONSUMED{"Total Energy Consumed", 0, 32};
+    }
+
+    // The registers below are only available on Intel CPUs
+
+    namespace INTEL_MSR_PKG_POWER_INFO
+    {
+        inline constexpr unsigned int ADDRESS = 0x614;
+        inline constexpr MsrField THERMAL_SPEC_POWER{"Thermal Spec Power", 0, 15};
+        inline constexpr MsrField MINIMUM_POWER{"Minimum Power", 16, 15};
+        inline constexpr MsrField MAXIMUM_POWER{"Maximum Power", 32, 15};
+        inline constexpr MsrField MAXIMUM_TIME_WINDOW{"Maximum Time Window", 48, 6};
+    }
+
+    namespace INTEL_MSR_PKG_POWER_LIMIT
+    {
+        inline constexpr unsigned int ADDRESS = 0x610;
+        inline constexpr MsrField POWER_LIMIT_1{"Package Power Limit #1", 0, 15};
+        inline constexpr MsrField ENABLE_LIMIT_1{"Enable Limit #1", 15, 1};
+        inline constexpr MsrField CLAMPING_LIMIT_1{"Package Clamping Limitation #1", 16, 1};
+        inline constexpr MsrField TIME_WINDOW_1{"Time Window for Power Limit #1", 17, 7};
+    }
+
+    // Accumulated time the package was throttled by RAPL, in time units
+    namespace INTEL_MSR_PKG_PERF_STATUS
+    {
+        inline constexpr unsigned int ADDRESS = 0x613;
+        inline constexpr MsrField THROTTLED_TIME{"Accumulated Package Throttled Time", 0, 32};
+    }
+
+    // The digital readout is the distance in degrees Celsius to TjMax
+    namespace IA32_PACKAGE_THERM_STATUS
+    {
+        inline constexpr unsigned int ADDRESS = 0x1B1;
+        inline constexpr MsrField THERMAL_STATUS{"Package Thermal Status", 0, 1};
+        inline constexpr MsrField PROCHOT_EVENT{"Package PROCHOT # Event", 2, 1};
+        inline constexpr MsrField POWER_LIMITATION_STATUS{"Package Power Limitation Status", 10, 1};
+        inline constexpr MsrField DIGITAL_READOUT{"Package Digital Readout", 16, 7};
+    }
+
+    namespace INTEL_MSR_TEMPERATURE_TARGET
+    {
+        inline constexpr unsigned int ADDRESS = 0x1A2;
+        inline constexpr MsrField TEMPERATURE_TARGET{"Temperature Target", 16, 8};
+    }
 } // namespace rapl_utils
 
 #endif
\ No newline at end of file
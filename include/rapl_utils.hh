@@ -34,21 +34,28 @@ namespace rapl_utils
         double total_energy{0};
     };
 
-    extern unsigned long long
-        INTEL_MSR_RAPL_POWER_UNIT_VALUES[INTEL_MSR_RAPL_POWER_UNIT_NUMFIELDS];
-    extern unsigned long long
-        INTEL_MSR_PKG_ENERGY_STATUS_VALUES[INTEL_MSR_PKG_ENERGY_STATUS_NUMFIELDS];
-    extern unsigned long long
-        INTEL_MSR_PP0_ENERGY_STATUS_VALUES[INTEL_MSR_PP0_ENERGY_STATUS_NUMFIELDS];
-    extern unsigned long long
-        INTEL_MSR_PKG_POWER_INFO_VALUES[INTEL_MSR_PKG_POWER_INFO_NUMFIELDS];
-
-    extern unsigned long long
-        AMD_MSR_RAPL_POWER_UNIT_VALUES[AMD_MSR_RAPL_POWER_UNIT_NUMFIELDS];
-    extern unsigned long long
-        AMD_MSR_PKG_ENERGY_STATUS_VALUES[AMD_MSR_PKG_ENERGY_STATUS_NUMFIELDS];
-    extern unsigned long long
-        AMD_MSR_CORE_ENERGY_STATUS_VALUES[AMD_MSR_CORE_ENERGY_STATUS_NUMFIELDS];
+    // This struct contains per-node throttling and thermal measurements along with the time they were taken
+    struct ThermalAux
+    {
+        // Timestamp when this struct was last updated
+        struct timespec time;
+        // Last measured accumulated throttled time per NUMA node, in seconds
+        float throttled_time[MAX_NUMA_NODES];
+        // Last measured package temperature per NUMA node, in degrees Celsius
+        float temperature[MAX_NUMA_NODES];
+        // Last measured package power limit #1 per NUMA node, in Watts
+        float power_limit[MAX_NUMA_NODES];
+    };
+
+    // Stores the percentage of the last measurement interval the packages were throttled
+    // (averaged over all packages), the temperature of the hottest package, and the
+    // aggregate power limit of all packages
+    struct ThermalData
+    {
+        double throttled_percent{0};
+        double temperature{0};
+        double power_limit{0};
+    };
 
     /*
     Store the increment for each unit in this machine
@@ -62,6 +69,11 @@ namespace rapl_utils
     */
     extern float energy_counter_max;
 
+    /*
+    Store the value at which the throttled time counter wraps around
+    */
+    extern float time_counter_max;
+
     /*
     Store NUMA-related information (Number of nodes, cores per node, id of
     the first core in each node)
@@ -69,18 +81,18 @@ namespace rapl_utils
     extern int numa_nodes;
 
     /*
-    Vendor ID enum
+    Vendor of the CPU, one of VENDOR_ID
     */
-    enum VENDOR_ID
-    {
-        INTEL,
-        AMD
-    };
     extern int vendor_id;
 
     extern std::unique_ptr<int[]> first_node_core;
     extern int numcores;
 
+    /*
+    Store the TjMax of each NUMA node in degrees Celsius, initialized by init_thermal()
+    */
+    extern std::unique_ptr<float[]> node_tjmax;
+
     //////////////////////////////////////////////////////////////////////
     //						  UTILITY FUNCTIONS
     //////////////////////////////////////////////////////////////////////
@@ -95,6 +107,7 @@ namespace rapl_utils
     Returns the last energy reading of the specified RAPL domain in Joules
     The value returned is the sum of the energy consumed by the CPU in the specified
     NUMA node
+    Reentrant, it only reads state that is set once by init()
     */
     float get_node_energy(int node, int domain);
 
@@ -137,33 +150,47 @@ namespace rapl_utils
     */
     float get_energy_diff(const float *current_energy, const float *previous_energy);
 
+    /*
+    Returns the energy consumed by a single NUMA node between two measurements, taking into
+    account possible hardware counter wraparounds
+    */
+    float get_node_energy_diff(float current_energy, float previous_energy);
+
     /*
     Returns the TDP of the CPU in Watts
     The value returned is the aggregate TDP of all the CPUs in the system
     */
     float get_processor_tdp();
 
-    //////////////////////////////////////////////////////////////////////
-    //						 READING MSR FIELDS
-    //////////////////////////////////////////////////////////////////////
-
     /*
-    Reads the MSR and stores its values in the provided array
-    These functions are mostly for convenience
+    Initializes the throttling and thermal measurements, reading the TjMax of each
+    NUMA node and reporting the power limits of each package. Only supported on Intel CPUs,
+    returns a non-zero value if thermal measurements are not available
     */
-    void read_INTEL_MSR_RAPL_POWER_UNIT(int core, unsigned long long *output);
-
-    void read_INTEL_MSR_PKG_ENERGY_STATUS(int core, unsigned long long *output);
+    int init_thermal();
 
-    void read_INTEL_MSR_PP0_ENERGY_STATUS(int core, unsigned long long *output);
-
-    void read_INTEL_MSR_PKG_POWER_INFO(int core, unsigned long long *output);
+    /*
+    Updates the input ThermalAux struct with the last per-node throttled time, package
+    temperature and package power limit
+    */
+    void update_package_thermal(ThermalAux &data);
 
-    void read_AMD_MSR_RAPL_POWER_UNIT(int core, unsigned long long *output);
+    /*
+    Uses the measurements from two ThermalAux structs to update the provided ThermalData struct. Sets the
+    percentage of the interval the packages were throttled, taking into account counter wraparounds, the
+    temperature of the hottest package and the aggregate power limit
+    */
+    void update_thermal_data(ThermalData &output_data, const ThermalAux &previous_data, const ThermalAux &current_data);
 
-    void read_AMD_MSR_PKG_ENERGY_STATUS(int core, unsigned long long *output);
+    //////////////////////////////////////////////////////////////////////
+    //						 READING MSR FIELDS
+    //////////////////////////////////////////////////////////////////////
 
-    void read_AMD_MSR_CORE_ENERGY_STATUS(int core, unsigned long long *output);
+    /*
+    Returns the raw value of the specified RAPL register, using the address that
+    corresponds to the vendor of this CPU
+    */
+    unsigned long long read_rapl_register(int core, RAPL_REGISTER reg);
 
 } // namespace rapl_utils
 
@@ -0,0 +1,39 @@
+#ifndef SESSION_HH
+#define SESSION_HH
+
+#include "power_meter.hh"
+#include "rapl_utils.hh"
+#include "nvml_utils.hh"
+
+namespace power_meter
+{
+    // Measures the energy consumed between a start_session() and a stop_session() call.
+    // Sessions only read the counters cached by power_meter::init(), so they can be started
+    // and stopped thousands of times per second. They must not be used once power_meter::shutdown()
+    // has been called. RAPL counters are updated roughly every millisecond, shorter sessions may
+    // measure no energy
+    struct Session
+    {
+        rapl_utils::EnergyAux cpu_start;
+        rapl_utils::EnergyAux cpu_stop;
+        nvml_utils::EnergyAux gpu_start;
+        nvml_utils::EnergyAux gpu_stop;
+        // Results of the last interval. The total energy accumulates over every
+        // interval measured with this session
+        rapl_utils::EnergyData cpu_results;
+        nvml_utils::EnergyData gpu_results;
+    };
+
+    /*
+    Take the starting snapshot of a session. init() must have been called
+    */
+    void start_session(Session &session);
+
+    /*
+    Take the final snapshot of a session and update its results with the energy and average
+    power of the interval
+    */
+    void stop_session(Session &session);
+}
+
+#endif
\ No newline at end of file
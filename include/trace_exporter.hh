@@ -0,0 +1,57 @@
+#ifndef TRACE_EXPORTER_HH
+#define TRACE_EXPORTER_HH
+
+#include "rapl_utils.hh"
+#include "nvml_utils.hh"
+
+#include <filesystem>
+
+/*
+Streams per-node CPU power and per-device GPU power as counter tracks in the Chrome JSON
+trace format, which can be loaded in chrome://tracing and the Perfetto UI.
+
+Events are written as they are produced, so memory use does not grow with the length of
+the run. Timestamps are in microseconds on CLOCK_MONOTONIC, the clock used by most tracing
+tools on Linux, so the counters can be overlaid on application traces. Replayed readings
+use the offset between both clocks of the recording run.
+*/
+namespace trace_exporter
+{
+    extern bool exporting;
+
+    /*
+    Returns the offset in microseconds that moves a CLOCK_REALTIME timestamp of this machine
+    to CLOCK_MONOTONIC
+    */
+    double get_realtime_to_monotonic_us();
+
+    /*
+    Open the trace file and write its header
+    clock_offset_us: Offset applied to the CLOCK_REALTIME timestamps of the readings. Use
+    get_realtime_to_monotonic_us() for live readings, and the offset of the recording run
+    when replaying
+    */
+    void open(const std::filesystem::path &filename, double clock_offset_us);
+
+    /*
+    Terminate the event array and close the trace file
+    */
+    void close();
+
+    /*
+    Write the average power of each NUMA node between two measurements
+    */
+    void write_cpu_power(const rapl_utils::EnergyAux &previous_data, const rapl_utils::EnergyAux &current_data);
+
+    /*
+    Write the average power of each GPU between two measurements
+    */
+    void write_gpu_power(const nvml_utils::EnergyAux &previous_data, const nvml_utils::EnergyAux &current_data);
+
+    /*
+    Write a power sample taken by the driver of a GPU, into the same track as write_gpu_power()
+    */
+    void write_gpu_power_sample(unsigned int gpu, const nvml_utils::PowerSample &sample);
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,73 @@
+#ifndef WORK_COUNTER_HH
+#define WORK_COUNTER_HH
+
+#include <atomic>
+
+namespace work_counter
+{
+    // Per-thread work counter, aligned to a cache line so that threads incrementing
+    // their own counter never share a line with another thread's counter
+    struct alignas(64) WorkSlot
+    {
+        // Only written by the owning thread, read by the monitoring thread
+        std::atomic<unsigned long long> ops{0};
+    };
+
+    // Stores the total number of application operations completed when it was last updated
+    struct WorkAux
+    {
+        unsigned long long ops{0};
+    };
+
+    // Stores the operations completed during the last measurement interval, and their efficiency
+    // according to the energy consumed during the same interval
+    struct WorkData
+    {
+        unsigned long long ops{0};
+        double joules_per_op{0};
+        double ops_per_watt{0};
+    };
+
+    // Counter of the calling thread, nullptr until the thread first reports work
+    extern thread_local WorkSlot *thread_slot;
+
+    /*
+    Allocates and registers a work counter for the calling thread. Takes a lock, but is only
+    called the first time each thread reports work
+    */
+    WorkSlot *register_thread();
+
+    /*
+    Reports that the calling thread completed the specified number of operations.
+    Lock-free, intended to be called from per-request hot paths
+    */
+    inline void add_work(unsigned long long ops = 1)
+    {
+        WorkSlot *slot = thread_slot;
+        if (!slot)
+            slot = register_thread();
+        // The owning thread is the only writer, so a relaxed load and store is enough
+        // and avoids a locked read-modify-write
+        slot->ops.store(slot->ops.load(std::memory_order_relaxed) + ops, std::memory_order_relaxed);
+    }
+
+    /*
+    Returns the sum of the operations reported by all threads, including threads that
+    have already exited
+    */
+    unsigned long long get_total_work();
+
+    /*
+    Updates the input WorkAux struct with the current total number of operations
+    */
+    void update_work(WorkAux &data);
+
+    /*
+    Uses the measurements from two WorkAux structs and the energy consumed between them to update the
+    provided WorkData struct. The efficiency values are set to 0 if no work or energy was measured
+    */
+    void update_work_data(WorkData &output_data, const WorkAux &previous_data, const WorkAux &current_data,
+                          double energy);
+}
+
+#endif
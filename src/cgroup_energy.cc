@@ -0,0 +1,129 @@
+#include "cgroup_energy.hh"
+
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+
+// Global variable definitions
+namespace cgroup_energy
+{
+    std::filesystem::path cgroup_root{"/sys/fs/cgroup"};
+    std::vector<std::string> cgroups;
+}
+
+void cgroup_energy::set_cgroup_root(std::string root)
+{
+    cgroup_root = root;
+}
+
+/*
+Returns whether one of the cgroups contains the other, or both are the same. The paths are
+compared component by component, so "a" contains "a/b" but not "ab"
+*/
+static bool cgroups_overlap(const std::filesystem::path &first, const std::filesystem::path &second)
+{
+    auto first_it = first.begin();
+    auto second_it = second.begin();
+    for (; first_it != first.end() && second_it != second.end(); ++first_it, ++second_it)
+    {
+        if (*first_it != *second_it)
+            return false;
+    }
+    return true;
+}
+
+int cgroup_energy::add_cgroup(std::string cgroup)
+{
+    if (cgroups.size() >= MAX_CGROUPS)
+    {
+        fprintf(stderr, "POWER METER: ERROR: At most %d cgroups can be monitored\n", MAX_CGROUPS);
+        return 1;
+    }
+    // Relative to the cgroup root, without trailing separators or "." components. The root itself
+    // becomes an empty path, which contains every other cgroup
+    auto path = std::filesystem::path(cgroup).relative_path().lexically_normal();
+    while (!path.empty() && (path.filename().empty() || path.filename() == "."))
+        path = path.parent_path();
+    for (const auto &monitored : cgroups)
+    {
+        // A parent's usage includes its children's, so they would be counted twice
+        if (cgroups_overlap(path, monitored))
+        {
+            fprintf(stderr, "POWER METER: ERROR: cgroup %s overlaps with the monitored cgroup %s\n", cgroup.c_str(),
+                    monitored.c_str());
+            return 1;
+        }
+    }
+    cgroups.push_back(path.string());
+    return 0;
+}
+
+unsigned long long cgroup_energy::get_cgroup_usage(const std::string &cgroup)
+{
+    auto filename = cgroup_root / cgroup / "cpu.stat";
+    FILE *cpu_stat = fopen(filename.c_str(), "r");
+    if (!cpu_stat)
+    {
+        fprintf(stderr, "POWER METER: ERROR: Could not read %s\n", filename.c_str());
+        return 0;
+    }
+
+    // Each line of cpu.stat is a "key value" pair, the total CPU time is usage_usec
+    char key[64];
+    unsigned long long value{0};
+    unsigned long long usage{0};
+    while (fscanf(cpu_stat, "%63s %llu", key, &value) == 2)
+    {
+        if (strcmp(key, "usage_usec") == 0)
+        {
+            usage = value;
+            break;
+        }
+    }
+    fclose(cpu_stat);
+    return usage;
+}
+
+void cgroup_energy::update_cgroup_usage(CgroupAux &data)
+{
+    for (size_t i = 0; i < cgroups.size(); i++)
+    {
+        data.usage_usec[i] = get_cgroup_usage(cgroups[i]);
+    }
+    clock_gettime(CLOCK_REALTIME, &data.time);
+}
+
+void cgroup_energy::update_cgroup_data(CgroupData &output_data, const CgroupAux &previous_data,
+                                       const CgroupAux &current_data, double energy, int num_cpus)
+{
+    double time_diff =
+        (double)(current_data.time.tv_sec - previous_data.time.tv_sec) +
+        ((double)(current_data.time.tv_nsec - previous_data.time.tv_nsec) / 1E9);
+    // CPU time available to all cgroups during the interval
+    double capacity_usec = num_cpus * time_diff * 1E6;
+
+    double shares[MAX_CGROUPS];
+    double attributed_share{0};
+    for (size_t i = 0; i < cgroups.size(); i++)
+    {
+        // Usage drops if a cgroup is recreated, count it as idle for this interval
+        double usage_diff = current_data.usage_usec[i] >= previous_data.usage_usec[i]
+                                ? (double)(current_data.usage_usec[i] - previous_data.usage_usec[i])
+                                : 0;
+        shares[i] = capacity_usec > 0 ? usage_diff / capacity_usec : 0;
+        attributed_share += shares[i];
+    }
+    // Sampling skew can make the shares add up to slightly more than the whole machine, scale
+    // them all down instead of favouring the cgroups read first
+    double scale = attributed_share > 1 ? 1 / attributed_share : 1;
+    attributed_share *= scale;
+
+    for (size_t i = 0; i < cgroups.size(); i++)
+    {
+        output_data.energy[i] = energy * shares[i] * scale;
+        output_data.power[i] = output_data.energy[i] / time_diff;
+        output_data.total_energy[i] += output_data.energy[i];
+    }
+    output_data.unattributed_energy = energy * (1 - attributed_share);
+    output_data.unattributed_power = output_data.unattributed_energy / time_diff;
+}
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include "energy_trace.hh"
+#include "trace_exporter.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <string>
+
+// Global variable definitions
+namespace energy_trace
+{
+    bool recording{false};
+    bool replaying{false};
+    std::ofstream record_file;
+    std::ifstream replay_file;
+    // The next line of the trace is read ahead so that its timestamp is known before replaying it
+    std::string next_line;
+    bool has_next_line{false};
+    // Timestamp of the last recorded or replayed reading
+    struct timespec last_time{};
+    // Live topology, overwritten by the trace's while replaying
+    int saved_numa_nodes{0};
+    float saved_energy_counter_max{0};
+    float saved_time_counter_max{0};
+    unsigned int saved_num_GPUs{0};
+    double clock_offset_us{0};
+}
+
+#define TRACE_MAGIC "POWER_METER_TRACE"
+#define TRACE_VERSION 1
+
+/*
+Writes the common prefix of a reading
+*/
+static std::ofstream &write_reading(const char *source, const struct timespec &time)
+{
+    energy_trace::last_time = time;
+    energy_trace::record_file << source << " " << time.tv_sec << " " << time.tv_nsec;
+    return energy_trace::record_file;
+}
+
+/*
+Reads the next line of the trace into next_line
+*/
+static void read_ahead()
+{
+    energy_trace::has_next_line = (bool)std::getline(energy_trace::replay_file, energy_trace::next_line);
+}
+
+/*
+Consumes the next reading if it belongs to the specified source, returning a stream positioned on
+its first value
+*/
+static bool next_reading(const char *source, struct timespec &time, std::istringstream &values)
+{
+    if (!energy_trace::has_next_line)
+        return false;
+
+    values.str(energy_trace::next_line);
+    std::string reading_source;
+    values >> reading_source >> time.tv_sec >> time.tv_nsec;
+    if (!values || reading_source != source)
+    {
+        fprintf(stderr, "POWER METER: ERROR: Expected a %s reading in the trace\n", source);
+        return false;
+    }
+    energy_trace::last_time = time;
+    read_ahead();
+    return true;
+}
+
+void energy_trace::start_recording(const std::filesystem::path &filename, bool thermal, bool work)
+{
+    record_file.open(filename);
+    // Readings are stored as floats, print them with enough digits to be read back exactly
+    record_file.precision(std::numeric_limits<float>::max_digits10);
+    record_file << TRACE_MAGIC << " " << TRACE_VERSION << "\n";
+    record_file << "rapl " << rapl_utils::numa_nodes << " " << rapl_utils::energy_counter_max << " "
+                << rapl_utils::time_counter_max << "\n";
+    record_file << "nvml " << nvml_utils::num_GPUs << "\n";
+    // Lets exported traces of a replay line up with the application traces of the recording run
+    record_file << "clock " << std::setprecision(std::numeric_limits<double>::max_digits10)
+                << trace_exporter::get_realtime_to_monotonic_us()
+                << std::setprecision(std::numeric_limits<float>::max_digits10) << "\n";
+    record_file << "sources cpu gpu" << (thermal ? " thermal" : "") << (work ? " work" : "") << "\n";
+    recording = true;
+    printf("POWER METER: Recording trace to %s\n", filename.c_str());
+}
+
+void energy_trace::stop_recording()
+{
+    recording = false;
+    record_file.close();
+}
+
+void energy_trace::record_cpu_energy(const rapl_utils::EnergyAux &data)
+{
+    auto &out = write_reading("cpu", data.time);
+    for (int i = 0; i < rapl_utils::numa_nodes; i++)
+        out << " " << data.energy[i];
+    out << "\n";
+}
+
+void energy_trace::record_gpu_energy(const nvml_utils::EnergyAux &data)
+{
+    auto &out = write_reading("gpu", data.time);
+    for (unsigned int i = 0; i < nvml_utils::num_GPUs; i++)
+        out << " " << data.energy[i];
+    out << "\n";
+}
+
+void energy_trace::record_thermal(const rapl_utils::ThermalAux &data)
+{
+    auto &out = write_reading("thermal", data.time);
+    for (int i = 0; i < rapl_utils::numa_nodes; i++)
+        out << " " << data.throttled_time[i] << " " << data.temperature[i] << " " << data.power_limit[i];
+    out << "\n";
+}
+
+void energy_trace::record_work(const work_counter::WorkAux &data)
+{
+    // Work counters carry no timestamp, they are sampled together with the previous readings
+    write_reading("work", last_time) << " " << data.ops << "\n";
+}
+
+int energy_trace::start_replay(const std::filesystem::path &filename, bool &thermal, bool &work)
+{
+    replay_file.open(filename);
+    if (!replay_file)
+    {
+        fprintf(stderr, "POWER METER: ERROR: Could not open trace %s\n", filename.c_str());
+        return 1;
+    }
+
+    std::string magic, key, source;
+    int version{0};
+    replay_file >> magic >> version;
+    if (magic != TRACE_MAGIC || version != TRACE_VERSION)
+    {
+        fprintf(stderr, "POWER METER: ERROR: %s is not a version %d trace\n", filename.c_str(), TRACE_VERSION);
+        replay_file.close();
+        return 1;
+    }
+    int trace_numa_nodes{0};
+    float trace_energy_counter_max{0};
+    float trace_time_counter_max{0};
+    unsigned int trace_num_GPUs{0};
+    replay_file >> key >> trace_numa_nodes >> trace_energy_counter_max >> trace_time_counter_max;
+    replay_file >> key >> trace_num_GPUs;
+    replay_file >> key >> clock_offset_us;
+    // Readings are replayed into the fixed size arrays of the EnergyAux structs
+    if (!replay_file || trace_numa_nodes < 0 || trace_numa_nodes > MAX_NUMA_NODES || trace_num_GPUs > MAX_GPUS)
+    {
+        fprintf(stderr, "POWER METER: ERROR: %s has an invalid topology (at most %d NUMA nodes and %d GPUs)\n",
+                filename.c_str(), MAX_NUMA_NODES, MAX_GPUS);
+        replay_file.close();
+        return 1;
+    }
+    replay_file >> key;
+    std::getline(replay_file, next_line);
+    std::istringstream sources(next_line);
+    thermal = work = false;
+    while (sources >> source)
+    {
+        thermal |= source == "thermal";
+        work |= source == "work";
+    }
+
+    // Keep the live topology, it is restored by stop_replay()
+    saved_numa_nodes = rapl_utils::numa_nodes;
+    saved_energy_counter_max = rapl_utils::energy_counter_max;
+    saved_time_counter_max = rapl_utils::time_counter_max;
+    saved_num_GPUs = nvml_utils::num_GPUs;
+    rapl_utils::numa_nodes = trace_numa_nodes;
+    rapl_utils::energy_counter_max = trace_energy_counter_max;
+    rapl_utils::time_counter_max = trace_time_counter_max;
+    nvml_utils::num_GPUs = trace_num_GPUs;
+
+    replaying = true;
+    read_ahead();
+    printf("POWER METER: Replaying trace %s, %d NUMA nodes, %u GPUs\n", filename.c_str(),
+           rapl_utils::numa_nodes, nvml_utils::num_GPUs);
+    return 0;
+}
+
+void energy_trace::stop_replay()
+{
+    if (replaying)
+    {
+        rapl_utils::numa_nodes = saved_numa_nodes;
+        rapl_utils::energy_counter_max = saved_energy_counter_max;
+        rapl_utils::time_counter_max = saved_time_counter_max;
+        nvml_utils::num_GPUs = saved_num_GPUs;
+    }
+    replaying = false;
+    has_next_line = false;
+    replay_file.close();
+}
+
+bool energy_trace::replay_cpu_energy(rapl_utils::EnergyAux &data)
+{
+    std::istringstream values;
+    if (!next_reading("cpu", data.time, values))
+        return false;
+    for (int i = 0; i < rapl_utils::numa_nodes; i++)
+        values >> data.energy[i];
+    return true;
+}
+
+bool energy_trace::replay_gpu_energy(nvml_utils::EnergyAux &data)
+{
+    std::istringstream values;
+    if (!next_reading("gpu", data.time, values))
+        return false;
+    for (unsigned int i = 0; i < nvml_utils::num_GPUs; i++)
+        values >> data.energy[i];
+    return true;
+}
+
+bool energy_trace::replay_thermal(rapl_utils::ThermalAux &data)
+{
+    std::istringstream values;
+    if (!next_reading("thermal", data.time, values))
+        return false;
+    for (int i = 0; i < rapl_utils::numa_nodes; i++)
+        values >> data.throttled_time[i] >> data.temperature[i] >> data.power_limit[i];
+    return true;
+}
+
+bool energy_trace::replay_work(work_counter::WorkAux &data)
+{
+    struct timespec time;
+    std::istringstream values;
+    if (!next_reading("work", time, values))
+        return false;
+    values >> data.ops;
+    return true;
+}
+
+double energy_trace::time_to_next_reading()
+{
+    if (!has_next_line)
+        return 0;
+    struct timespec time;
+    std::istringstream values(next_line);
+    std::string source;
+    values >> source >> time.tv_sec >> time.tv_nsec;
+    return (double)(time.tv_sec - last_time.tv_sec) + ((double)(time.tv_nsec - last_time.tv_nsec) / 1E9);
+}
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "msr_batch_reader.hh"
+#include "msr_reader.hh"
+
+#include <errno.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define MSR_BATCH_HAVE_IO_URING
+#endif
+
+using namespace rapl_utils;
+
+#ifdef MSR_BATCH_HAVE_IO_URING
+/*
+Minimal io_uring instance, set up through the raw system calls so that no additional
+library is needed. Only used from the thread reading the batch
+*/
+struct MsrRing
+{
+  int fd{-1};
+  // Submission queue
+  unsigned *sq_tail;
+  unsigned *sq_mask;
+  unsigned *sq_array;
+  struct io_uring_sqe *sqes;
+  // Completion queue
+  unsigned *cq_head;
+  unsigned *cq_tail;
+  unsigned *cq_mask;
+  struct io_uring_cqe *cqes;
+  // Mappings, released by close_msr_batch()
+  void *sq_ring{MAP_FAILED};
+  size_t sq_ring_size{0};
+  void *cq_ring{MAP_FAILED};
+  size_t cq_ring_size{0};
+  size_t sqes_size{0};
+};
+#endif
+
+// Global variable definitions
+namespace rapl_utils
+{
+  bool msr_batch_uring{false};
+  std::unique_ptr<int[]> batch_cores;
+  int batch_count{0};
+#ifdef MSR_BATCH_HAVE_IO_URING
+  MsrRing batch_ring;
+#endif
+}
+
+#ifdef MSR_BATCH_HAVE_IO_URING
+/*
+Creates the io_uring instance and maps its queues. Returns false if io_uring or its read
+operation is not available, e.g. on old kernels or when it is disabled by a seccomp filter
+*/
+static bool setup_ring(MsrRing &ring, unsigned int entries)
+{
+  struct io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  ring.fd = (int)syscall(__NR_io_uring_setup, entries, &params);
+  if (ring.fd < 0)
+    return false;
+
+  ring.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+  // Newer kernels map both rings with a single mmap
+  bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+  if (single_mmap)
+    ring.sq_ring_size = ring.cq_ring_size = std::max(ring.sq_ring_size, ring.cq_ring_size);
+
+  ring.sq_ring = mmap(nullptr, ring.sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring.fd, IORING_OFF_SQ_RING);
+  if (ring.sq_ring == MAP_FAILED)
+    return false;
+  if (single_mmap)
+  {
+    ring.cq_ring = ring.sq_ring;
+  }
+  else
+  {
+    ring.cq_ring = mmap(nullptr, ring.cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring.fd, IORING_OFF_CQ_RING);
+    if (ring.cq_ring == MAP_FAILED)
+      return false;
+  }
+  ring.sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+  void *sqes = mmap(nullptr, ring.sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                    ring.fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+    return false;
+  ring.sqes = (struct io_uring_sqe *)sqes;
+
+  char *sq = (char *)ring.sq_ring;
+  ring.sq_tail = (unsigned *)(sq + params.sq_off.tail);
+  ring.sq_mask = (unsigned *)(sq + params.sq_off.ring_mask);
+  ring.sq_array = (unsigned *)(sq + params.sq_off.array);
+  char *cq = (char *)ring.cq_ring;
+  ring.cq_head = (unsigned *)(cq + params.cq_off.head);
+  ring.cq_tail = (unsigned *)(cq + params.cq_off.tail);
+  ring.cq_mask = (unsigned *)(cq + params.cq_off.ring_mask);
+  ring.cqes = (struct io_uring_cqe *)(cq + params.cq_off.cqes);
+
+  // IORING_OP_READ is only supported from Linux 5.6, older kernels accept the ring but fail
+  // every read with EINVAL. Probing was added in the same release, so a failed probe also
+  // means the opcode is missing
+  alignas(struct io_uring_probe) char probe_buffer[sizeof(struct io_uring_probe) +
+                                                   IORING_OP_LAST * sizeof(struct io_uring_probe_op)];
+  memset(probe_buffer, 0, sizeof(probe_buffer));
+  struct io_uring_probe *probe = (struct io_uring_probe *)probe_buffer;
+  if (syscall(__NR_io_uring_register, ring.fd, IORING_REGISTER_PROBE, probe, IORING_OP_LAST) < 0)
+    return false;
+  return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+}
+
+static void release_ring(MsrRing &ring)
+{
+  if (ring.sqes_size)
+    munmap(ring.sqes, ring.sqes_size);
+  if (ring.cq_ring != MAP_FAILED && ring.cq_ring != ring.sq_ring)
+    munmap(ring.cq_ring, ring.cq_ring_size);
+  if (ring.sq_ring != MAP_FAILED)
+    munmap(ring.sq_ring, ring.sq_ring_size);
+  if (ring.fd >= 0)
+    close(ring.fd);
+  ring = MsrRing{};
+}
+
+/*
+Submits one read per core and waits for all of them with a single io_uring_enter call.
+Returns false if the batch could not be fully submitted, once every submitted read has
+completed, so that none of them writes to values afterwards. Reads that fail individually
+are retried with pread
+*/
+static bool read_batch_uring(MsrRing &ring, unsigned int address, unsigned long long *values)
+{
+  unsigned tail = *ring.sq_tail;
+  for (int i = 0; i < batch_count; i++)
+  {
+    unsigned index = tail & *ring.sq_mask;
+    struct io_uring_sqe *sqe = &ring.sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = IORING_OP_READ;
+    sqe->fd = fileno(msr_files[batch_cores[i]]);
+    sqe->addr = (unsigned long long)&values[i];
+    sqe->len = sizeof(unsigned long long);
+    sqe->off = address;
+    sqe->user_data = i;
+    ring.sq_array[index] = index;
+    tail++;
+  }
+  // Publish the new entries before the kernel reads the tail
+  __atomic_store_n(ring.sq_tail, tail, __ATOMIC_RELEASE);
+
+  long submitted = syscall(__NR_io_uring_enter, ring.fd, batch_count, batch_count, IORING_ENTER_GETEVENTS,
+                           nullptr, 0);
+  if (submitted < 0)
+    submitted = 0;
+
+  // The wait may end early, e.g. when interrupted by a signal, wait again until every
+  // submitted read has completed
+  long completed = 0;
+  while (true)
+  {
+    unsigned head = *ring.cq_head;
+    unsigned cq_tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != cq_tail; head++, completed++)
+    {
+      struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+      if (cqe->res != sizeof(unsigned long long))
+      {
+        int i = (int)cqe->user_data;
+        values[i] = read_msr(msr_files[batch_cores[i]], address);
+      }
+    }
+    __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    if (completed >= submitted)
+      break;
+    if (syscall(__NR_io_uring_enter, ring.fd, 0, submitted - completed, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 &&
+        errno != EINTR)
+      break;
+  }
+
+  // Entries left in the submission queue point to the caller's buffer, the ring can't be reused
+  return submitted == batch_count && completed == submitted;
+}
+#endif
+
+void rapl_utils::init_msr_batch(const int *cores, int count)
+{
+  batch_cores = std::make_unique<int[]>(count);
+  batch_count = count;
+  for (int i = 0; i < count; i++)
+  {
+    batch_cores[i] = cores[i];
+    cache_msr_file(cores[i]);
+  }
+
+#ifdef MSR_BATCH_HAVE_IO_URING
+  msr_batch_uring = setup_ring(batch_ring, count);
+  if (!msr_batch_uring)
+    release_ring(batch_ring);
+#endif
+  printf("POWER METER: Reading MSRs of %d cores %s\n", count,
+         msr_batch_uring ? "in io_uring batches" : "with one pread per core");
+}
+
+void rapl_utils::close_msr_batch()
+{
+#ifdef MSR_BATCH_HAVE_IO_URING
+  release_ring(batch_ring);
+#endif
+  msr_batch_uring = false;
+  batch_cores.reset();
+  batch_count = 0;
+}
+
+void rapl_utils::read_msr_batch(unsigned int address, unsigned long long *values)
+{
+#ifdef MSR_BATCH_HAVE_IO_URING
+  if (msr_batch_uring)
+  {
+    if (read_batch_uring(batch_ring, address, values))
+      return;
+    // Disable io_uring rather than submitting the leftover entries with a later batch
+    fprintf(stderr, "POWER METER: WARNING: Could not submit the MSR batch, falling back to one pread per core\n");
+    release_ring(batch_ring);
+    msr_batch_uring = false;
+  }
+#endif
+  for (int i = 0; i < batch_count; i++)
+  {
+    values[i] = read_msr(msr_files[batch_cores[i]], address);
+  }
+}
\ No newline at end of file
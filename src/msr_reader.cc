@@ -3,14 +3,21 @@
 #include <filesystem>
 #include <system_error>
 
-#define BUFFER_SIZE 32
+#define BUFFER_SIZE 256
 
 using namespace rapl_utils;
 
+// Global variable definitions
+namespace rapl_utils
+{
+  std::vector<FILE *> msr_files;
+  std::string msr_dir{"/dev/cpu"};
+}
+
 FILE *rapl_utils::open_msr(int core)
 {
   char filename[BUFFER_SIZE];
-  snprintf(filename, BUFFER_SIZE, "/dev/cpu/%d/msr", core);
+  snprintf(filename, BUFFER_SIZE, "%s/%d/msr", msr_dir.c_str(), core);
   FILE *file = fopen(filename, "rb");
 
   if (!file)
@@ -28,41 +35,70 @@ unsigned long long rapl_utils::read_msr(FILE *file, unsigned int address)
   // According to the specification, a long long is at least 64 bits long
   unsigned long long data;
 
-  pread(fileno(file), &data, 8, address);
+  // The msr driver fails with EIO for registers this CPU doesn't implement,
+  // report them as 0 instead of returning an uninitialized value
+  if (pread(fileno(file), &data, 8, address) != 8)
+  {
+    data = 0;
+  }
 
   return data;
 }
 
-void rapl_utils::read_msr_fields(int core, const unsigned int msr_address,
-                                 const unsigned int msr_numfields,
-                                 const unsigned int *msr_offsets,
-                                 const unsigned int *msr_sizes,
-                                 unsigned long long *msr_values)
+bool rapl_utils::probe_msr(int core, unsigned int address)
 {
-  unsigned long long field = 0;
+  unsigned long long data;
+  if ((size_t)core < msr_files.size() && msr_files[core])
+  {
+    return pread(fileno(msr_files[core]), &data, 8, address) == 8;
+  }
 
   FILE *file = open_msr(core);
-  unsigned long long data = read_msr(file, msr_address);
+  bool readable = pread(fileno(file), &data, 8, address) == 8;
+  fclose(file);
+
+  return readable;
+}
 
-  // Parse the fields and store their values
-  for (unsigned int i = 0; i < msr_numfields; i++)
+unsigned long long rapl_utils::read_msr(int core, unsigned int address)
+{
+  if ((size_t)core < msr_files.size() && msr_files[core])
   {
-    field = 0;
-    field = data >> msr_offsets[i];
-    field = field & get_mask(msr_sizes[i]);
-    msr_values[i] = field;
+    return read_msr(msr_files[core], address);
   }
 
+  FILE *file = open_msr(core);
+  unsigned long long data = read_msr(file, address);
   fclose(file);
+
+  return data;
+}
+
+void rapl_utils::cache_msr_file(int core)
+{
+  if ((size_t)core >= msr_files.size())
+  {
+    msr_files.resize(core + 1, nullptr);
+  }
+  if (!msr_files[core])
+  {
+    msr_files[core] = open_msr(core);
+  }
 }
 
-unsigned long long rapl_utils::get_mask(unsigned int size)
+void rapl_utils::close_msr_files()
 {
-  unsigned long long mask = 0;
-  for (unsigned int i = 0; i < size; i++)
+  for (FILE *file : msr_files)
   {
-    mask = mask << 1;
-    mask += 1;
+    if (file)
+    {
+      fclose(file);
+    }
   }
-  return mask;
+  msr_files.clear();
+}
+
+void rapl_utils::set_msr_dir(std::string dir)
+{
+  msr_dir = dir;
 }
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "node_reader.hh"
+
+#include <pthread.h>
+#include <sched.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace rapl_utils;
+
+// Reader state. Requests are published through request_generation and completions counted in
+// pending_nodes, both atomics waited on with futexes, so that a sample takes no lock shared
+// between nodes and only two futex wakes are on the critical path
+namespace rapl_utils
+{
+  std::vector<std::thread> node_readers;
+  // Incremented on every request, readers compare it against the last one they served.
+  // 32 bits wide, as required by futex
+  std::atomic<unsigned int> request_generation{0};
+  std::atomic<int> pending_nodes{0};
+  std::atomic<bool> stop_readers{false};
+  // Written before request_generation is incremented, read by the readers after they see it
+  int requested_domain{0};
+  EnergyAux *requested_data{nullptr};
+  // Serializes callers of update_aux_data_parallel
+  std::mutex sample_mutex;
+}
+
+static_assert(sizeof(std::atomic<unsigned int>) == sizeof(unsigned int) && sizeof(std::atomic<int>) == sizeof(int),
+              "futexes need the atomics to have the layout of a plain int");
+
+/*
+Blocks while the 32-bit value at the specified address still holds the expected value. May
+return spuriously, callers check the value again
+*/
+static void futex_wait(void *address, int expected)
+{
+  syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, expected, nullptr, nullptr, 0);
+}
+
+static void futex_wake(void *address, int count)
+{
+  syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, count, nullptr, nullptr, 0);
+}
+
+/*
+Loop run by the reader thread of a NUMA node. Waits for a request, reads the node's
+energy counter into its own slot and reports back when it is the last node done
+*/
+static void node_reader_loop(int node, unsigned int served_generation)
+{
+  // Pin this thread to the node so that the MSR read does not need a cross-socket IPI
+  cpu_set_t cpuset;
+  CPU_ZERO(&cpuset);
+  CPU_SET(first_node_core[node], &cpuset);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) != 0)
+  {
+    fprintf(stderr, "POWER METER: WARNING: Could not pin the reader of node %d to core %d\n",
+            node, first_node_core[node]);
+  }
+
+  while (true)
+  {
+    unsigned int generation;
+    while ((generation = request_generation.load(std::memory_order_acquire)) == served_generation)
+    {
+      futex_wait(&request_generation, (int)served_generation);
+    }
+    served_generation = generation;
+    if (stop_readers.load(std::memory_order_relaxed))
+      return;
+
+    requested_data->energy[node] = get_node_energy(node, requested_domain);
+    // The last reader publishes every slot to the requester
+    if (pending_nodes.fetch_sub(1, std::memory_order_acq_rel) == 1)
+      futex_wake(&pending_nodes, 1);
+  }
+}
+
+void rapl_utils::start_node_readers()
+{
+  std::lock_guard<std::mutex> sample_lock(sample_mutex);
+  stop_readers.store(false, std::memory_order_relaxed);
+  for (int i = 0; i < numa_nodes; i++)
+  {
+    // Readers start from the current generation, so that requests served by a previous set
+    // of readers are not served again. It is read here rather than in the reader, which may
+    // only start running after the first new request
+    node_readers.emplace_back(node_reader_loop, i, request_generation.load(std::memory_order_relaxed));
+  }
+  printf("POWER METER: Started %d per-node readers\n", numa_nodes);
+}
+
+void rapl_utils::stop_node_readers()
+{
+  {
+    std::lock_guard<std::mutex> sample_lock(sample_mutex);
+    stop_readers.store(true, std::memory_order_relaxed);
+    // The caller of the last request may be gone by the time readers are started again
+    requested_data = nullptr;
+    request_generation.fetch_add(1, std::memory_order_release);
+    futex_wake(&request_generation, INT_MAX);
+  }
+  for (auto &reader : node_readers)
+  {
+    reader.join();
+  }
+  node_readers.clear();
+}
+
+void rapl_utils::update_aux_data_parallel(EnergyAux &data, int domain)
+{
+  std::lock_guard<std::mutex> sample_lock(sample_mutex);
+  requested_domain = domain;
+  requested_data = &data;
+  pending_nodes.store(numa_nodes, std::memory_order_relaxed);
+  request_generation.fetch_add(1, std::memory_order_release);
+  futex_wake(&request_generation, INT_MAX);
+
+  int pending;
+  while ((pending = pending_nodes.load(std::memory_order_acquire)) != 0)
+  {
+    futex_wait(&pending_nodes, pending);
+  }
+  clock_gettime(CLOCK_REALTIME, &data.time);
+}
+
+void rapl_utils::update_package_energy_parallel(EnergyAux &data) { update_aux_data_parallel(data, 0); }
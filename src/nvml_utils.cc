@@ -1,6 +1,7 @@
 #include "nvml_utils.hh"
 
 #include <cstdio>
+#include <algorithm>
 #include <time.h>
 
 // Global variable definitions
@@ -8,6 +9,9 @@ namespace nvml_utils
 {
     unsigned int num_GPUs{0};
     std::unique_ptr<nvmlDevice_t[]> device_handles;
+    std::unique_ptr<unsigned long long[]> last_sample_timestamp;
+    // Reused between calls to avoid allocating on every interval
+    std::vector<nvmlSample_t> sample_buffer;
 }
 
 void nvml_utils::init()
@@ -18,6 +22,8 @@ void nvml_utils::init()
     {
         nvmlDeviceGetHandleByIndex_v2(i, &device_handles[i]);
     }
+    last_sample_timestamp = std::make_unique<unsigned long long[]>(num_GPUs);
+    reset_power_samples();
     printf("POWER METER: Number of GPUs detected: %d\n", num_GPUs);
 }
 
@@ -62,4 +68,67 @@ void nvml_utils::update_energy_data(EnergyData &output_data, const EnergyAux &pr
     output_data.power = (float)(energy_diff / time_diff);
     output_data.energy = energy_diff;
     output_data.total_energy += energy_diff;
+}
+
+/*
+Converts a sample value to a double according to the type reported by NVML
+*/
+static double sample_value(const nvmlValue_t &value, nvmlValueType_t type)
+{
+    switch (type)
+    {
+    case NVML_VALUE_TYPE_DOUBLE:
+        return value.dVal;
+    case NVML_VALUE_TYPE_UNSIGNED_LONG:
+        return (double)value.ulVal;
+    case NVML_VALUE_TYPE_UNSIGNED_LONG_LONG:
+        return (double)value.ullVal;
+    default:
+        return (double)value.uiVal;
+    }
+}
+
+void nvml_utils::reset_power_samples()
+{
+    // NVML timestamps are microseconds since the epoch
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    for (unsigned int i = 0; i < num_GPUs; ++i)
+    {
+        last_sample_timestamp[i] = (unsigned long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+    }
+}
+
+nvmlReturn_t nvml_utils::get_power_samples(unsigned int gpu, std::vector<PowerSample> &samples)
+{
+    samples.clear();
+    nvmlValueType_t value_type;
+    unsigned int sample_count{0};
+    // A first call without a buffer returns the number of samples available
+    auto nvml_error = nvmlDeviceGetSamples(device_handles[gpu], NVML_TOTAL_POWER_SAMPLES, last_sample_timestamp[gpu],
+                                           &value_type, &sample_count, nullptr);
+    if (nvml_error == NVML_SUCCESS)
+    {
+        sample_buffer.resize(sample_count);
+        nvml_error = nvmlDeviceGetSamples(device_handles[gpu], NVML_TOTAL_POWER_SAMPLES, last_sample_timestamp[gpu],
+                                          &value_type, &sample_count, sample_buffer.data());
+    }
+    // No samples were taken since the last call
+    if (nvml_error == NVML_ERROR_NOT_FOUND)
+        return NVML_SUCCESS;
+    if (nvml_error != NVML_SUCCESS)
+        return nvml_error;
+
+    for (unsigned int i = 0; i < sample_count; ++i)
+    {
+        if (sample_buffer[i].timeStamp <= last_sample_timestamp[gpu])
+            continue;
+        // Power samples are reported in mili Watts
+        samples.push_back({sample_buffer[i].timeStamp, sample_value(sample_buffer[i].sampleValue, value_type) / 1E3});
+    }
+    for (const auto &sample : samples)
+    {
+        last_sample_timestamp[gpu] = std::max(last_sample_timestamp[gpu], sample.timestamp);
+    }
+    return NVML_SUCCESS;
 }
\ No newline at end of file
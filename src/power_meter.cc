@@ -2,55 +2,391 @@
 #include "rapl_utils.hh"
 #include "nvml_utils.hh"
 #include "msr_reader.hh"
+#include "work_counter.hh"
+#include "node_reader.hh"
+#include "energy_trace.hh"
+#include "trace_exporter.hh"
+#include "cgroup_energy.hh"
 
 #include <nvml.h>
+#include <pthread.h>
+#include <sched.h>
 #include <thread>
 #include <chrono>
 #include <algorithm>
+#include <iterator>
+#include <vector>
+#include <string>
+#include <cmath>
 
 // Initialize global variables
 namespace power_meter
 {
     bool do_monitoring{true};
     std::thread monitoring_thread;
+    bool thermal_monitoring{false};
+    bool work_monitoring{false};
+    bool parallel_node_reading{false};
+    bool gpu_power_samples{false};
+    double replay_speedup{0};
+    bool adaptive_sampling{false};
+    unsigned int burst_interval_ms{1};
+    double burst_threshold_watts{0};
+    std::atomic<bool> burst_triggered{false};
+    int monitoring_core{-1};
+    int monitoring_sched_policy{SCHED_OTHER};
+    int monitoring_sched_priority{0};
+    WakeupStats wakeup_stats;
     std::filesystem::path output_dir{"power_meter_out"};
     std::filesystem::path cpu_out_filename{"cpu"};
     std::filesystem::path gpu_out_filename{"gpu"};
+    std::filesystem::path gpu_samples_out_filename{"gpu_samples"};
+    std::filesystem::path cgroups_out_filename{"cgroups"};
+    std::filesystem::path record_filename;
+    std::filesystem::path chrome_trace_filename;
     std::ofstream cpu_out;
     std::ofstream gpu_out;
+    std::ofstream gpu_samples_out;
+    std::ofstream cgroups_out;
 }
 
+// GPUs found not to keep power samples during the current monitoring loop, only their energy
+// counter is polled. Reset on every launch
+static bool gpu_samples_unsupported[MAX_GPUS];
+static unsigned int gpus_without_samples{0};
+
 void power_meter::launch_monitoring_loop(unsigned int sampling_interval_ms)
 {   
-    // Check whether we have access to the MSR files
-    rapl_utils::open_msr(0);
-    // Intel: Initialize internal counters
-    if (rapl_utils::init() != 0)
+    // Initialize the sources, only done the first time
+    if (init() != 0)
+        return;
+    // Intel: Read TjMax and power limits, thermal measurements are disabled if unsupported
+    if (thermal_monitoring && rapl_utils::init_thermal() != 0)
     {
-        fprintf(stderr, "POWER METER: An error was encountered during initialization\n");
+        thermal_monitoring = false;
+    }
+    // Create the output directory before launching the thread, so that errors are reported here
+    // instead of terminating the program from the monitoring thread
+    std::error_code error;
+    std::filesystem::create_directory(output_dir, error);
+    if (error)
+    {
+        fprintf(stderr, "POWER METER: ERROR: Could not create output directory %s: %s\n", output_dir.c_str(),
+                error.message().c_str());
         return;
     }
-    // Open output files
-    std::filesystem::create_directory(output_dir);
+    // CUDA: Skip the power samples taken before this loop, e.g. during a previous one
+    if (gpu_power_samples)
+    {
+        nvml_utils::reset_power_samples();
+        std::fill(std::begin(gpu_samples_unsupported), std::end(gpu_samples_unsupported), false);
+        gpus_without_samples = 0;
+    }
+    // CPU: Launch one pinned reader per NUMA node
+    if (parallel_node_reading)
+        rapl_utils::start_node_readers();
+    // Launch monitoring on a separate thread, it opens the output files itself
+    do_monitoring = true;
+    wakeup_stats = WakeupStats{};
+    monitoring_thread = std::thread(monitoring_thread_main, sampling_interval_ms);
+}
+
+/*
+Formats the cores in a CPU set as a list of ranges, e.g. "0-3,8"
+*/
+static std::string format_cpuset(const cpu_set_t &cpuset)
+{
+    std::string list;
+    for (int core = 0; core < CPU_SETSIZE; ++core)
+    {
+        if (!CPU_ISSET(core, &cpuset))
+            continue;
+        int last = core;
+        while (last + 1 < CPU_SETSIZE && CPU_ISSET(last + 1, &cpuset))
+            ++last;
+        if (!list.empty())
+            list += ",";
+        list += std::to_string(core);
+        if (last > core)
+            list += "-" + std::to_string(last);
+        core = last;
+    }
+    return list;
+}
+
+/*
+Applies the configured affinity and scheduling to the calling thread and reports them
+*/
+static void apply_monitoring_thread_settings()
+{
+    if (power_meter::monitoring_core >= 0)
+    {
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(power_meter::monitoring_core, &cpuset);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset) != 0)
+            fprintf(stderr, "POWER METER: WARNING: Could not pin the monitoring thread to core %d\n",
+                    power_meter::monitoring_core);
+    }
+    if (power_meter::monitoring_sched_policy != SCHED_OTHER)
+    {
+        struct sched_param param;
+        param.sched_priority = power_meter::monitoring_sched_priority;
+        // Real-time policies usually need CAP_SYS_NICE, keep the default policy otherwise
+        if (pthread_setschedparam(pthread_self(), power_meter::monitoring_sched_policy, &param) != 0)
+            fprintf(stderr, "POWER METER: WARNING: Could not set the scheduling policy of the monitoring thread\n");
+    }
+
+    // Report the settings that were actually applied
+    cpu_set_t cpuset;
+    CPU_ZERO(&cpuset);
+    pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), &cpuset);
+    int policy;
+    struct sched_param param;
+    pthread_getschedparam(pthread_self(), &policy, &param);
+    const char *policy_name = "SCHED_OTHER";
+    if (policy == SCHED_FIFO)
+        policy_name = "SCHED_FIFO";
+    else if (policy == SCHED_RR)
+        policy_name = "SCHED_RR";
+    printf("POWER METER: Monitoring thread on core %d (allowed cores: %s), policy %s, priority %d\n",
+           sched_getcpu(), format_cpuset(cpuset).c_str(), policy_name, param.sched_priority);
+}
+
+void power_meter::monitoring_thread_main(unsigned int sampling_interval_ms)
+{
+    apply_monitoring_thread_settings();
+
+    // Open output files from this thread, once it is pinned, so that their buffers are
+    // first touched, and thus allocated, on the monitoring thread's NUMA node. The output
+    // directory was created by launch_monitoring_loop()
     cpu_out.open(output_dir / cpu_out_filename);
     gpu_out.open(output_dir / gpu_out_filename);
+    if (!cpu_out.is_open() || !gpu_out.is_open())
+        fprintf(stderr, "POWER METER: ERROR: Could not open the output files in %s\n", output_dir.c_str());
+    if (gpu_power_samples)
+    {
+        gpu_samples_out.open(output_dir / gpu_samples_out_filename);
+        gpu_samples_out << "Timestamp, GPU, Power" << std::endl;
+    }
+    if (!cgroup_energy::cgroups.empty())
+    {
+        cgroups_out.open(output_dir / cgroups_out_filename);
+        for (const auto &cgroup : cgroup_energy::cgroups)
+            cgroups_out << cgroup << " energy, " << cgroup << " power, ";
+        cgroups_out << "Unattributed energy, Unattributed power" << std::endl;
+    }
+    // Record every reading if requested, the topology is known at this point
+    if (!record_filename.empty())
+        energy_trace::start_recording(output_dir / record_filename, thermal_monitoring, work_monitoring);
+    // Export power as counter tracks if requested
+    if (!chrome_trace_filename.empty())
+        trace_exporter::open(output_dir / chrome_trace_filename, trace_exporter::get_realtime_to_monotonic_us());
 
-    // CUDA: Start nvml
-    nvmlInit_v2();
-    // Intel: Initialize number of GPUs and device handles
-    nvml_utils::init();
-    // Launch monitoring on a separate thread
-    do_monitoring = true;
-    monitoring_thread = std::thread(monitoring_loop, sampling_interval_ms);
+    monitoring_loop(sampling_interval_ms);
 }
 
 void power_meter::stop_monitoring_loop()
 {
     // Stop monitoring thread
     do_monitoring = false;
-    monitoring_thread.join();
-    // CUDA: Stop nvml
-    nvmlShutdown();
+    // The thread is not running if launch_monitoring_loop() failed
+    if (monitoring_thread.joinable())
+        monitoring_thread.join();
+    if (wakeup_stats.samples > 0)
+    {
+        printf("POWER METER: Monitoring thread wakeup latency: mean %.1f us, max %.1f us over %llu samples\n",
+               wakeup_stats.total_latency_us / wakeup_stats.samples, wakeup_stats.max_latency_us,
+               wakeup_stats.samples);
+    }
+    if (parallel_node_reading)
+        rapl_utils::stop_node_readers();
+    cpu_out.close();
+    gpu_out.close();
+    if (gpu_samples_out.is_open())
+        gpu_samples_out.close();
+    if (cgroups_out.is_open())
+        cgroups_out.close();
+    if (energy_trace::recording)
+        energy_trace::stop_recording();
+    if (trace_exporter::exporting)
+        trace_exporter::close();
+    // The sources stay initialized for further sessions or monitoring loops, see shutdown()
+}
+
+void power_meter::replay_trace(std::string trace_filename, double speedup)
+{
+    // A live loop would read the trace's topology and write to the same output files
+    if (monitoring_thread.joinable())
+    {
+        fprintf(stderr, "POWER METER: ERROR: Can't replay a trace while the monitoring loop is running\n");
+        return;
+    }
+    // Create the output directory before the trace's topology replaces the live one, see
+    // launch_monitoring_loop()
+    std::error_code error;
+    std::filesystem::create_directory(output_dir, error);
+    if (error)
+    {
+        fprintf(stderr, "POWER METER: ERROR: Could not create output directory %s: %s\n", output_dir.c_str(),
+                error.message().c_str());
+        return;
+    }
+    // The trace decides which optional sources are replayed, restore the live settings afterwards
+    bool live_thermal_monitoring = thermal_monitoring;
+    bool live_work_monitoring = work_monitoring;
+    if (energy_trace::start_replay(trace_filename, thermal_monitoring, work_monitoring) != 0)
+    {
+        fprintf(stderr, "POWER METER: An error was encountered during initialization\n");
+        thermal_monitoring = live_thermal_monitoring;
+        work_monitoring = live_work_monitoring;
+        return;
+    }
+    replay_speedup = speedup;
+    // Open output files
+    cpu_out.open(output_dir / cpu_out_filename);
+    gpu_out.open(output_dir / gpu_out_filename);
+    if (cpu_out.is_open() && gpu_out.is_open())
+    {
+        if (!chrome_trace_filename.empty())
+            trace_exporter::open(output_dir / chrome_trace_filename, energy_trace::clock_offset_us);
+
+        // The loop runs until the trace is exhausted
+        do_monitoring = true;
+        monitoring_loop(0);
+    }
+    else
+    {
+        fprintf(stderr, "POWER METER: ERROR: Could not open the output files in %s\n", output_dir.c_str());
+    }
+
+    cpu_out.close();
+    gpu_out.close();
+    if (trace_exporter::exporting)
+        trace_exporter::close();
+    energy_trace::stop_replay();
+    thermal_monitoring = live_thermal_monitoring;
+    work_monitoring = live_work_monitoring;
+}
+
+/*
+Reads the package energy of all nodes, in parallel if enabled
+*/
+static void update_cpu_energy(rapl_utils::EnergyAux &data)
+{
+    if (power_meter::parallel_node_reading)
+        rapl_utils::update_package_energy_parallel(data);
+    else
+        rapl_utils::update_package_energy(data);
+}
+
+/*
+Takes a reading of every enabled source, from the hardware or from the trace being replayed,
+recording it if requested. Returns false once the trace being replayed is exhausted
+*/
+static bool read_sources(rapl_utils::EnergyAux &cpu_data, nvml_utils::EnergyAux &cuda_data,
+                         rapl_utils::ThermalAux &thermal_data, work_counter::WorkAux &work_data)
+{
+    if (energy_trace::replaying)
+    {
+        return energy_trace::replay_cpu_energy(cpu_data) &&
+               energy_trace::replay_gpu_energy(cuda_data) &&
+               (!power_meter::thermal_monitoring || energy_trace::replay_thermal(thermal_data)) &&
+               (!power_meter::work_monitoring || energy_trace::replay_work(work_data));
+    }
+
+    // CPU: Get the current energy measurement for RAPL's package domain
+    update_cpu_energy(cpu_data);
+    // CUDA
+    nvml_utils::update_gpu_energy(cuda_data);
+    // CPU: Get the current throttled time and temperature
+    if (power_meter::thermal_monitoring)
+        rapl_utils::update_package_thermal(thermal_data);
+    // Get the operations completed so far
+    if (power_meter::work_monitoring)
+        work_counter::update_work(work_data);
+
+    if (energy_trace::recording)
+    {
+        energy_trace::record_cpu_energy(cpu_data);
+        energy_trace::record_gpu_energy(cuda_data);
+        if (power_meter::thermal_monitoring)
+            energy_trace::record_thermal(thermal_data);
+        if (power_meter::work_monitoring)
+            energy_trace::record_work(work_data);
+    }
+    return true;
+}
+
+/*
+Writes the power samples buffered by the NVML driver since the last interval. GPUs that don't
+keep power samples are left to the energy counter for the rest of the loop, other errors only
+skip the GPU for this interval
+*/
+static void harvest_gpu_power_samples()
+{
+    static std::vector<nvml_utils::PowerSample> samples;
+    for (unsigned int i = 0; i < nvml_utils::num_GPUs; ++i)
+    {
+        if (gpu_samples_unsupported[i])
+            continue;
+        auto nvml_error = nvml_utils::get_power_samples(i, samples);
+        if (nvml_error == NVML_ERROR_NOT_SUPPORTED)
+        {
+            fprintf(stderr, "POWER METER: GPU %u does not provide power samples, falling back to energy polling\n", i);
+            gpu_samples_unsupported[i] = true;
+            gpus_without_samples++;
+            continue;
+        }
+        if (nvml_error != NVML_SUCCESS)
+        {
+            fprintf(stderr, "POWER METER: WARNING: Could not read the power samples of GPU %u (NVML error %d)\n", i,
+                    (int)nvml_error);
+            continue;
+        }
+        for (const auto &sample : samples)
+        {
+            power_meter::gpu_samples_out << sample.timestamp << "," << i << "," << sample.power << "\n";
+            if (trace_exporter::exporting)
+                trace_exporter::write_gpu_power_sample(i, sample);
+        }
+    }
+}
+
+/*
+Waits until the next reading should be taken. When replaying, waits for the recorded
+interval divided by the replay speedup, or not at all if the speedup is 0
+*/
+static void wait_for_next_reading(unsigned int sampling_interval_ms)
+{
+    if (!energy_trace::replaying)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(sampling_interval_ms));
+        // Wakeup latency: time slept beyond the requested interval
+        double latency_us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() -
+                            sampling_interval_ms * 1E3;
+        power_meter::wakeup_stats.samples++;
+        power_meter::wakeup_stats.total_latency_us += latency_us;
+        power_meter::wakeup_stats.max_latency_us = std::max(power_meter::wakeup_stats.max_latency_us, latency_us);
+    }
+    else if (power_meter::replay_speedup > 0)
+        std::this_thread::sleep_for(std::chrono::duration<double>(
+            energy_trace::time_to_next_reading() / power_meter::replay_speedup));
+}
+
+/*
+Returns the interval until the next sample when adaptive sampling is enabled. Switches to the
+burst interval on a power transient or an application trigger, otherwise doubles the current
+interval until it decays back to the base interval
+*/
+static unsigned int next_sampling_interval(unsigned int current_interval_ms, unsigned int base_interval_ms,
+                                           double power_change)
+{
+    bool triggered = power_meter::burst_triggered.exchange(false, std::memory_order_relaxed);
+    if (triggered || std::abs(power_change) > power_meter::burst_threshold_watts)
+        return power_meter::burst_interval_ms;
+    return std::min(current_interval_ms * 2, base_interval_ms);
 }
 
 /*
@@ -66,36 +402,128 @@ void power_meter::monitoring_loop(unsigned int sampling_interval_ms)
     nvml_utils::EnergyAux cuda_data;
     nvml_utils::EnergyAux current_cuda_data;
     nvml_utils::EnergyData cuda_results;
+    // Structs used to take throttling and thermal measurements
+    rapl_utils::ThermalAux cpu_thermal_data;
+    rapl_utils::ThermalAux current_cpu_thermal_data;
+    rapl_utils::ThermalData cpu_thermal_results;
+    // Structs used to compute the energy efficiency per application operation
+    work_counter::WorkAux work_data;
+    work_counter::WorkAux current_work_data;
+    work_counter::WorkData cpu_work_results;
+    work_counter::WorkData cuda_work_results;
+    // Structs used to attribute package energy to cgroups. CPU usage is not part of replay traces
+    bool cgroup_attribution = !cgroup_energy::cgroups.empty() && !energy_trace::replaying;
+    cgroup_energy::CgroupAux cgroup_data;
+    cgroup_energy::CgroupAux current_cgroup_data;
+    cgroup_energy::CgroupData cgroup_results;
 
-    // Get the initial energy readings
-    // CPU: Get the current energy measurement for RAPL's package domain
-    rapl_utils::update_package_energy(cpu_pkg_data);
-    // CUDA
-    nvml_utils::update_gpu_energy(cuda_data);
+    // Interval until the next sample, only changes with adaptive sampling
+    unsigned int current_interval_ms = sampling_interval_ms;
+    double previous_power{0};
+    // There is no previous power to compare against until the first interval is computed
+    bool have_previous_power{false};
+
+    // Get the initial readings
+    if (!read_sources(cpu_pkg_data, cuda_data, cpu_thermal_data, work_data))
+        return;
+    if (cgroup_attribution)
+        cgroup_energy::update_cgroup_usage(cgroup_data);
 
     // Write the header for the output files
     auto output_header = "Power, Energy, Total energy";
-    cpu_out << output_header << std::endl;
-    gpu_out << output_header << std::endl;
+    auto work_header = ", Ops, Joules per op, Ops per watt";
+    cpu_out << output_header;
+    if (thermal_monitoring)
+        cpu_out << ", Throttled %, Temperature, Power limit";
+    if (work_monitoring)
+        cpu_out << work_header;
+    if (adaptive_sampling)
+        cpu_out << ", Interval";
+    cpu_out << std::endl;
+    gpu_out << output_header;
+    if (work_monitoring)
+        gpu_out << work_header;
+    if (adaptive_sampling)
+        gpu_out << ", Interval";
+    gpu_out << std::endl;
 
     while (do_monitoring)
     {
-        std::this_thread::sleep_for(std::chrono::milliseconds(sampling_interval_ms));
-        // CPU: Update energy measurements
-        rapl_utils::update_package_energy(current_cpu_pkg_data);
+        wait_for_next_reading(current_interval_ms);
+        // Update the readings of all sources
+        if (!read_sources(current_cpu_pkg_data, current_cuda_data, current_cpu_thermal_data, current_work_data))
+            break;
         // CPU: Compute energy and average power usage for this interval, update total energy consumption
         rapl_utils::update_energy_data(cpu_pkg_results, cpu_pkg_data, current_cpu_pkg_data);
-        // CUDA: Update energy measurements
-        nvml_utils::update_gpu_energy(current_cuda_data);
         // CUDA: Compute energy and average power usage for this interval, update total energy consumption
         nvml_utils::update_energy_data(cuda_results, cuda_data, current_cuda_data);
+        // Export per-node and per-device power. Driver samples replace the per-interval GPU power
+        if (trace_exporter::exporting)
+        {
+            trace_exporter::write_cpu_power(cpu_pkg_data, current_cpu_pkg_data);
+            if (!gpu_power_samples || energy_trace::replaying || gpus_without_samples == nvml_utils::num_GPUs)
+                trace_exporter::write_gpu_power(cuda_data, current_cuda_data);
+        }
+        // CPU: Split this interval's package energy between the monitored cgroups
+        if (cgroup_attribution)
+        {
+            cgroup_energy::update_cgroup_usage(current_cgroup_data);
+            cgroup_energy::update_cgroup_data(cgroup_results, cgroup_data, current_cgroup_data,
+                                              cpu_pkg_results.energy, rapl_utils::numcores);
+            std::swap(cgroup_data, current_cgroup_data);
+            for (size_t i = 0; i < cgroup_energy::cgroups.size(); i++)
+                cgroups_out << cgroup_results.energy[i] << "," << cgroup_results.power[i] << ",";
+            cgroups_out << cgroup_results.unattributed_energy << "," << cgroup_results.unattributed_power << std::endl;
+        }
+        // CUDA: Merge the driver's power samples for this interval, they are not part of replay traces
+        if (gpu_power_samples && !energy_trace::replaying)
+            harvest_gpu_power_samples();
+        // CPU: Compute throttling and thermal results for this interval
+        if (thermal_monitoring)
+        {
+            rapl_utils::update_thermal_data(cpu_thermal_results, cpu_thermal_data, current_cpu_thermal_data);
+            std::swap(cpu_thermal_data, current_cpu_thermal_data);
+        }
+        // Work: Attribute this interval's operations to the energy consumed by each source
+        if (work_monitoring)
+        {
+            work_counter::update_work_data(cpu_work_results, work_data, current_work_data, cpu_pkg_results.energy);
+            work_counter::update_work_data(cuda_work_results, work_data, current_work_data, cuda_results.energy);
+            std::swap(work_data, current_work_data);
+        }
+
+        // Effective interval of this sample in ms, may differ from the requested one
+        double interval_ms =
+            (double)(current_cpu_pkg_data.time.tv_sec - cpu_pkg_data.time.tv_sec) * 1E3 +
+            ((double)(current_cpu_pkg_data.time.tv_nsec - cpu_pkg_data.time.tv_nsec) / 1E6);
+        // Adapt the sampling rate to the change in total power
+        if (adaptive_sampling)
+        {
+            double power = cpu_pkg_results.power + cuda_results.power;
+            if (have_previous_power)
+                current_interval_ms = next_sampling_interval(current_interval_ms, sampling_interval_ms, power - previous_power);
+            previous_power = power;
+            have_previous_power = true;
+        }
 
         // Swap structs for the next iteration
         std::swap(cpu_pkg_data, current_cpu_pkg_data);
         std::swap(cuda_data, current_cuda_data);
 
-        cpu_out << cpu_pkg_results.power << "," << cpu_pkg_results.energy << "," << cpu_pkg_results.total_energy << std::endl;
-        gpu_out << cuda_results.power << "," << cuda_results.energy << "," << cuda_results.total_energy << std::endl;
+        cpu_out << cpu_pkg_results.power << "," << cpu_pkg_results.energy << "," << cpu_pkg_results.total_energy;
+        if (thermal_monitoring)
+            cpu_out << "," << cpu_thermal_results.throttled_percent << "," << cpu_thermal_results.temperature << "," << cpu_thermal_results.power_limit;
+        if (work_monitoring)
+            cpu_out << "," << cpu_work_results.ops << "," << cpu_work_results.joules_per_op << "," << cpu_work_results.ops_per_watt;
+        if (adaptive_sampling)
+            cpu_out << "," << interval_ms;
+        cpu_out << std::endl;
+        gpu_out << cuda_results.power << "," << cuda_results.energy << "," << cuda_results.total_energy;
+        if (work_monitoring)
+            gpu_out << "," << cuda_work_results.ops << "," << cuda_work_results.joules_per_op << "," << cuda_work_results.ops_per_watt;
+        if (adaptive_sampling)
+            gpu_out << "," << interval_ms;
+        gpu_out << std::endl;
     }
 }
 
@@ -114,3 +542,67 @@ void power_meter::set_gpu_out_filename(std::string filename)
     gpu_out_filename = filename;
 }
 
+void power_meter::set_thermal_monitoring(bool enable)
+{
+    thermal_monitoring = enable;
+}
+
+void power_meter::set_work_monitoring(bool enable)
+{
+    work_monitoring = enable;
+}
+
+void power_meter::set_parallel_node_reading(bool enable)
+{
+    parallel_node_reading = enable;
+}
+
+void power_meter::set_record_filename(std::string filename)
+{
+    record_filename = filename;
+}
+
+void power_meter::set_chrome_trace_filename(std::string filename)
+{
+    chrome_trace_filename = filename;
+}
+
+void power_meter::set_gpu_power_samples(bool enable)
+{
+    gpu_power_samples = enable;
+}
+
+void power_meter::set_gpu_samples_out_filename(std::string filename)
+{
+    gpu_samples_out_filename = filename;
+}
+
+void power_meter::set_cgroups_out_filename(std::string filename)
+{
+    cgroups_out_filename = filename;
+}
+
+void power_meter::set_adaptive_sampling(bool enable, unsigned int burst_interval, double threshold_watts)
+{
+    adaptive_sampling = enable;
+    // The interval doubles while decaying, so it can't start at 0
+    burst_interval_ms = std::max(burst_interval, 1u);
+    burst_threshold_watts = threshold_watts;
+}
+
+void power_meter::set_monitoring_affinity(int core)
+{
+    monitoring_core = core;
+}
+
+void power_meter::set_monitoring_scheduling(int policy, int priority)
+{
+    monitoring_sched_policy = policy;
+    monitoring_sched_priority = priority;
+}
+
+void power_meter::trigger_burst()
+{
+    burst_triggered.store(true, std::memory_order_relaxed);
+}
+
@@ -4,31 +4,25 @@
 #include <stdlib.h>
 #include <string.h>
 #include <chrono>
+#include <algorithm>
 
 using namespace rapl_utils;
 
 // Global variable definitions
 namespace rapl_utils
 {
-  // MSR value arrays
-  unsigned long long INTEL_MSR_RAPL_POWER_UNIT_VALUES[INTEL_MSR_RAPL_POWER_UNIT_NUMFIELDS];
-  unsigned long long AMD_MSR_RAPL_POWER_UNIT_VALUES[AMD_MSR_RAPL_POWER_UNIT_NUMFIELDS];
-  unsigned long long INTEL_MSR_PKG_ENERGY_STATUS_VALUES[INTEL_MSR_PKG_ENERGY_STATUS_NUMFIELDS];
-  unsigned long long AMD_MSR_PKG_ENERGY_STATUS_VALUES[AMD_MSR_PKG_ENERGY_STATUS_NUMFIELDS];
-  unsigned long long INTEL_MSR_PP0_ENERGY_STATUS_VALUES[INTEL_MSR_PP0_ENERGY_STATUS_NUMFIELDS];
-  unsigned long long AMD_MSR_CORE_ENERGY_STATUS_VALUES[AMD_MSR_CORE_ENERGY_STATUS_NUMFIELDS];
-  unsigned long long INTEL_MSR_PKG_POWER_INFO_VALUES[INTEL_MSR_PKG_POWER_INFO_NUMFIELDS];
-
   // Energy measurement variables
   float power_increment{0};
   float energy_increment{0};
   float time_increment{0};
   float energy_counter_max{0};
+  float time_counter_max{0};
 
   int numa_nodes{0};
   std::unique_ptr<int[]> first_node_core;
   int numcores{0};
   int vendor_id{-1};
+  std::unique_ptr<float[]> node_tjmax;
 }
 
 //////////////////////////////////////////////////////////////////////
@@ -66,6 +60,7 @@ int rapl_utils::init()
   case 0x6c65746e:
     vendor_id = VENDOR_ID::INTEL;
     printf("POWER METER: CPU Vendor ID: Intel\n");
+    break;
   case 0x444d4163:
     vendor_id = VENDOR_ID::AMD;
     printf("POWER METER: CPU Vendor ID: AMD\n");
@@ -78,11 +73,11 @@ int rapl_utils::init()
   // Get the number of NUMA nodes. This file contains a list of node IDs
   // separated by "-". The length in characters of the file will be 2 for 1 node
   // (0 + \n), and increase by 2 for each succesive node
+  char buffer[16];
   FILE *nodes = fopen("/sys/devices/system/node/online", "r");
-  char *nodelist = fgets((char *)malloc(16 * sizeof(char)), 16, nodes);
+  char *nodelist = fgets(buffer, 16, nodes);
   fclose(nodes);
   numa_nodes = (int)strlen(nodelist) / 2;
-  free(nodelist);
 
   // Allocate space for the variables of each node
   first_node_core = std::make_unique<int[]>(numa_nodes);
@@ -95,44 +90,37 @@ int rapl_utils::init()
     FILE *cpulist = fopen(filename, "r");
     // Reads the file and gets the first token (The id of the first core in the
     // NUMA node)
-    first_node_core[i] = atoi(
-        strtok(fgets((char *)malloc(16 * sizeof(char)), 16, cpulist), "-"));
+    first_node_core[i] = atoi(strtok(fgets(buffer, 16, cpulist), "-"));
     fclose(cpulist);
   }
 
   // Get the total number of cores, gets the number of the last online
-  // core (should be all cores in the system), and adds 1
+  // core (should be all cores in the system), and adds 1. A single core is listed without a range
   FILE *onlinecores = fopen("/sys/devices/system/cpu/online", "r");
-  numcores =
-      atoi(strrchr(fgets((char *)malloc(16 * sizeof(char)), 16, onlinecores),
-                   '-') +
-           1) +
-      1;
+  char *corelist = fgets(buffer, 16, onlinecores);
+  char *last_range = strrchr(corelist, '-');
+  numcores = atoi(last_range ? last_range + 1 : corelist) + 1;
   fclose(onlinecores);
 
-  if (vendor_id == VENDOR_ID::INTEL)
-  {
-    read_INTEL_MSR_RAPL_POWER_UNIT(0, INTEL_MSR_RAPL_POWER_UNIT_VALUES);
-    power_increment =
-        1 / (float)(1 << (unsigned int)INTEL_MSR_RAPL_POWER_UNIT_VALUES[0]);
-    energy_increment =
-        1 / (float)(1 << (unsigned int)INTEL_MSR_RAPL_POWER_UNIT_VALUES[1]);
-    time_increment =
-        1 / (float)(1 << (unsigned int)INTEL_MSR_RAPL_POWER_UNIT_VALUES[2]);
-  }
-  else if (vendor_id == VENDOR_ID::AMD)
+  // Keep the MSR file of the core used to read each node open, so that each
+  // reading is a single pread
+  for (int i = 0; i < numa_nodes; i++)
   {
-    read_AMD_MSR_RAPL_POWER_UNIT(0, AMD_MSR_RAPL_POWER_UNIT_VALUES);
-    power_increment =
-        1 / (float)(1 << (unsigned int)AMD_MSR_RAPL_POWER_UNIT_VALUES[0]);
-    energy_increment =
-        1 / (float)(1 << (unsigned int)AMD_MSR_RAPL_POWER_UNIT_VALUES[1]);
-    time_increment =
-        1 / (float)(1 << (unsigned int)AMD_MSR_RAPL_POWER_UNIT_VALUES[2]);
+    cache_msr_file(first_node_core[i]);
   }
 
+  unsigned long long power_unit = read_rapl_register(0, RAPL_POWER_UNIT);
+  power_increment =
+      1 / (float)(1 << (unsigned int)MSR_RAPL_POWER_UNIT::POWER_UNITS.decode(power_unit));
+  energy_increment =
+      1 / (float)(1 << (unsigned int)MSR_RAPL_POWER_UNIT::ENERGY_STATUS_UNITS.decode(power_unit));
+  time_increment =
+      1 / (float)(1 << (unsigned int)MSR_RAPL_POWER_UNIT::TIME_UNITS.decode(power_unit));
+
   // The maximum value of the energy counter is 2^32, stored here in joules
   energy_counter_max = ((long)1U << 32) * energy_increment;
+  // Same for the throttled time counter, stored in seconds
+  time_counter_max = ((long)1U << 32) * time_increment;
 
   printf("POWER METER: Number of NUMA nodes detected: %d\n", numa_nodes);
 
@@ -145,30 +133,14 @@ float rapl_utils::get_node_energy(int node, int domain)
   {
   // Package
   case 0:
-    if (vendor_id == VENDOR_ID::INTEL)
-    {
-      read_INTEL_MSR_PKG_ENERGY_STATUS(first_node_core[node], INTEL_MSR_PKG_ENERGY_STATUS_VALUES);
-      return (float)INTEL_MSR_PKG_ENERGY_STATUS_VALUES[0] * energy_increment;
-    }
-    else
-    {
-      read_AMD_MSR_PKG_ENERGY_STATUS(first_node_core[node], AMD_MSR_PKG_ENERGY_STATUS_VALUES);
-      return (float)AMD_MSR_PKG_ENERGY_STATUS_VALUES[0] * energy_increment;
-    }
-    break;
+    return (float)MSR_ENERGY_STATUS::TOTAL_ENERGY_CONSUMED.decode(
+               read_rapl_register(first_node_core[node], PKG_ENERGY_STATUS)) *
+           energy_increment;
   // Cores
   case 1:
-    if (vendor_id == VENDOR_ID::INTEL)
-    {
-      read_INTEL_MSR_PP0_ENERGY_STATUS(first_node_core[node], INTEL_MSR_PP0_ENERGY_STATUS_VALUES);
-      return (float)INTEL_MSR_PP0_ENERGY_STATUS_VALUES[0] * energy_increment;
-    }
-    else
-    {
-      read_AMD_MSR_CORE_ENERGY_STATUS(first_node_core[node], AMD_MSR_CORE_ENERGY_STATUS_VALUES);
-      return (float)AMD_MSR_CORE_ENERGY_STATUS_VALUES[0] * energy_increment;
-    }
-    break;
+    return (float)MSR_ENERGY_STATUS::TOTAL_ENERGY_CONSUMED.decode(
+               read_rapl_register(first_node_core[node], CORE_ENERGY_STATUS)) *
+           energy_increment;
   // Uncore
   case 2:
     fprintf(stderr, "Reading from RAPL's Uncore domain not yet implemented");
@@ -199,22 +171,27 @@ void rapl_utils::update_package_energy(EnergyAux &data) { update_aux_data(data,
 
 void rapl_utils::update_cores_energy(EnergyAux &data) { update_aux_data(data, 1); }
 
+float rapl_utils::get_node_energy_diff(float current_energy, float previous_energy)
+{
+  float node_energy_diff = current_energy - previous_energy;
+  /*
+  If the energy counter has wrapped around for this node, we need to add the
+  value before wrapping around to the diff. This is 2^32 per Intel's
+  specification
+  */
+  if (node_energy_diff < 0)
+  {
+    node_energy_diff += energy_counter_max;
+  }
+  return node_energy_diff;
+}
+
 float rapl_utils::get_energy_diff(const float *current_energy, const float *previous_energy)
 {
   float energy_diff = 0;
   for (int i = 0; i < numa_nodes; i++)
   {
-    float node_energy_diff = (float)(current_energy[i] - previous_energy[i]);
-    /*
-    If the energy counter has wrapped around for this node, we need to add the
-    value before wrapping around to the diff. This is 2^32 per Intel's
-    specification
-    */
-    if (node_energy_diff < 0)
-    {
-      node_energy_diff += energy_counter_max;
-    }
-    energy_diff += node_energy_diff;
+    energy_diff += get_node_energy_diff(current_energy[i], previous_energy[i]);
   }
   return energy_diff;
 }
@@ -246,7 +223,7 @@ void rapl_utils::update_energy_data(EnergyData &output_data, const EnergyAux &pr
 
 float rapl_utils::get_processor_tdp()
 {
-  if (!vendor_id == VENDOR_ID::INTEL)
+  if (vendor_id != VENDOR_ID::INTEL)
   {
     fprintf(stderr, "POWER METER: ERROR: get_processor_tdp() only works with Intel CPUs\n");
     return 0;
@@ -256,69 +233,110 @@ float rapl_utils::get_processor_tdp()
 
   for (int i = 0; i < numa_nodes; i++)
   {
-    read_INTEL_MSR_PKG_POWER_INFO(first_node_core[i], INTEL_MSR_PKG_POWER_INFO_VALUES);
-    total_tdp += (float)INTEL_MSR_PKG_POWER_INFO_VALUES[0];
+    total_tdp += (float)INTEL_MSR_PKG_POWER_INFO::THERMAL_SPEC_POWER.decode(
+        read_msr(first_node_core[i], INTEL_MSR_PKG_POWER_INFO::ADDRESS));
   }
 
   return total_tdp * power_increment;
 }
 
-//////////////////////////////////////////////////////////////////////
-//						          READING MSR FIELDS
-//////////////////////////////////////////////////////////////////////
-
-void rapl_utils::read_INTEL_MSR_RAPL_POWER_UNIT(int core, unsigned long long *output)
+int rapl_utils::init_thermal()
 {
-  read_msr_fields(
-      core, INTEL_MSR_RAPL_POWER_UNIT, INTEL_MSR_RAPL_POWER_UNIT_NUMFIELDS,
-      INTEL_MSR_RAPL_POWER_UNIT_OFFSETS, INTEL_MSR_RAPL_POWER_UNIT_SIZES,
-      output);
-}
+  if (vendor_id != VENDOR_ID::INTEL)
+  {
+    fprintf(stderr, "POWER METER: ERROR: Throttling and thermal measurements are only supported on Intel CPUs\n");
+    return 1;
+  }
 
-void rapl_utils::read_INTEL_MSR_PKG_ENERGY_STATUS(int core, unsigned long long *output)
-{
-  read_msr_fields(
-      core, INTEL_MSR_PKG_ENERGY_STATUS, INTEL_MSR_PKG_ENERGY_STATUS_NUMFIELDS,
-      INTEL_MSR_PKG_ENERGY_STATUS_OFFSETS, INTEL_MSR_PKG_ENERGY_STATUS_SIZES,
-      output);
-}
+  // Not every Intel CPU implements these registers, e.g. MSR_PKG_PERF_STATUS is missing on
+  // many client parts
+  const unsigned int thermal_registers[] = {
+      INTEL_MSR_PKG_PERF_STATUS::ADDRESS, IA32_PACKAGE_THERM_STATUS::ADDRESS,
+      INTEL_MSR_TEMPERATURE_TARGET::ADDRESS, INTEL_MSR_PKG_POWER_LIMIT::ADDRESS};
+  for (int i = 0; i < numa_nodes; i++)
+  {
+    for (unsigned int address : thermal_registers)
+    {
+      if (!probe_msr(first_node_core[i], address))
+      {
+        fprintf(stderr, "POWER METER: ERROR: MSR 0x%X is not available on node %d, throttling and thermal measurements disabled\n",
+                address, i);
+        return 1;
+      }
+    }
+  }
 
-void rapl_utils::read_INTEL_MSR_PP0_ENERGY_STATUS(int core, unsigned long long *output)
-{
-  read_msr_fields(
-      core, INTEL_MSR_PP0_ENERGY_STATUS, INTEL_MSR_PP0_ENERGY_STATUS_NUMFIELDS,
-      INTEL_MSR_PP0_ENERGY_STATUS_OFFSETS, INTEL_MSR_PP0_ENERGY_STATUS_SIZES,
-      output);
-}
+  node_tjmax = std::make_unique<float[]>(numa_nodes);
 
-void rapl_utils::read_INTEL_MSR_PKG_POWER_INFO(int core, unsigned long long *output)
-{
-  read_msr_fields(
-      core, INTEL_MSR_PKG_POWER_INFO, INTEL_MSR_PKG_POWER_INFO_NUMFIELDS,
-      INTEL_MSR_PKG_POWER_INFO_OFFSETS, INTEL_MSR_PKG_POWER_INFO_SIZES,
-      output);
+  for (int i = 0; i < numa_nodes; i++)
+  {
+    node_tjmax[i] = (float)INTEL_MSR_TEMPERATURE_TARGET::TEMPERATURE_TARGET.decode(
+        read_msr(first_node_core[i], INTEL_MSR_TEMPERATURE_TARGET::ADDRESS));
+
+    unsigned long long power_info = read_msr(first_node_core[i], INTEL_MSR_PKG_POWER_INFO::ADDRESS);
+    printf("POWER METER: Node %d: TjMax %.0f C, Thermal spec power %.2f W, Minimum power %.2f W, Maximum power %.2f W\n",
+           i, node_tjmax[i],
+           INTEL_MSR_PKG_POWER_INFO::THERMAL_SPEC_POWER.decode(power_info) * power_increment,
+           INTEL_MSR_PKG_POWER_INFO::MINIMUM_POWER.decode(power_info) * power_increment,
+           INTEL_MSR_PKG_POWER_INFO::MAXIMUM_POWER.decode(power_info) * power_increment);
+  }
+
+  return 0;
 }
 
-void rapl_utils::read_AMD_MSR_RAPL_POWER_UNIT(int core, unsigned long long *output)
+void rapl_utils::update_package_thermal(ThermalAux &data)
 {
-  read_msr_fields(
-      core, AMD_MSR_RAPL_POWER_UNIT, AMD_MSR_RAPL_POWER_UNIT_NUMFIELDS,
-      AMD_MSR_RAPL_POWER_UNIT_OFFSETS, AMD_MSR_RAPL_POWER_UNIT_SIZES,
-      output);
+  for (int i = 0; i < numa_nodes; i++)
+  {
+    int core = first_node_core[i];
+    data.throttled_time[i] = (float)INTEL_MSR_PKG_PERF_STATUS::THROTTLED_TIME.decode(
+                                 read_msr(core, INTEL_MSR_PKG_PERF_STATUS::ADDRESS)) *
+                             time_increment;
+
+    // The digital readout is the number of degrees below TjMax
+    data.temperature[i] = node_tjmax[i] - (float)IA32_PACKAGE_THERM_STATUS::DIGITAL_READOUT.decode(
+                                              read_msr(core, IA32_PACKAGE_THERM_STATUS::ADDRESS));
+
+    data.power_limit[i] = (float)INTEL_MSR_PKG_POWER_LIMIT::POWER_LIMIT_1.decode(
+                              read_msr(core, INTEL_MSR_PKG_POWER_LIMIT::ADDRESS)) *
+                          power_increment;
+  }
+  clock_gettime(CLOCK_REALTIME, &data.time);
 }
 
-void rapl_utils::read_AMD_MSR_PKG_ENERGY_STATUS(int core, unsigned long long *output)
+void rapl_utils::update_thermal_data(ThermalData &output_data, const ThermalAux &previous_data, const ThermalAux &current_data)
 {
-  read_msr_fields(
-      core, AMD_MSR_PKG_ENERGY_STATUS, AMD_MSR_PKG_ENERGY_STATUS_NUMFIELDS,
-      AMD_MSR_PKG_ENERGY_STATUS_OFFSETS, AMD_MSR_PKG_ENERGY_STATUS_SIZES,
-      output);
+  double time_diff =
+      (double)(current_data.time.tv_sec - previous_data.time.tv_sec) +
+      ((double)(current_data.time.tv_nsec - previous_data.time.tv_nsec) / 1E9);
+
+  float throttled_diff = 0;
+  float max_temperature = 0;
+  float power_limit = 0;
+  for (int i = 0; i < numa_nodes; i++)
+  {
+    float node_throttled_diff = current_data.throttled_time[i] - previous_data.throttled_time[i];
+    // The throttled time counter is 32 bits wide and wraps around like the energy counter
+    if (node_throttled_diff < 0)
+    {
+      node_throttled_diff += time_counter_max;
+    }
+    throttled_diff += node_throttled_diff;
+    max_temperature = std::max(max_temperature, current_data.temperature[i]);
+    power_limit += current_data.power_limit[i];
+  }
+
+  // Average over all packages, each of them can be throttled for the whole interval
+  output_data.throttled_percent = 100 * throttled_diff / (time_diff * numa_nodes);
+  output_data.temperature = max_temperature;
+  output_data.power_limit = power_limit;
 }
 
-void rapl_utils::read_AMD_MSR_CORE_ENERGY_STATUS(int core, unsigned long long *output)
+//////////////////////////////////////////////////////////////////////
+//						          READING MSR FIELDS
+//////////////////////////////////////////////////////////////////////
+
+unsigned long long rapl_utils::read_rapl_register(int core, RAPL_REGISTER reg)
 {
-  read_msr_fields(
-      core, AMD_MSR_CORE_ENERGY_STATUS, AMD_MSR_CORE_ENERGY_STATUS_NUMFIELDS,
-      AMD_MSR_CORE_ENERGY_STATUS_OFFSETS, AMD_MSR_CORE_ENERGY_STATUS_SIZES,
-      output);
+  return read_msr(core, RAPL_REGISTER_ADDRESSES[vendor_id][reg]);
 }
\ No newline at end of file
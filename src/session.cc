@@ -0,0 +1,62 @@
+#include "session.hh"
+#include "msr_reader.hh"
+
+#include <nvml.h>
+#include <cstdio>
+
+// Global variable definitions
+namespace power_meter
+{
+    bool initialized{false};
+}
+
+int power_meter::init()
+{
+    if (initialized)
+        return 0;
+
+    // Check whether we have access to the MSR files, throws otherwise
+    fclose(rapl_utils::open_msr(0));
+    // Intel: Initialize internal counters
+    if (rapl_utils::init() != 0)
+    {
+        fprintf(stderr, "POWER METER: An error was encountered during initialization\n");
+        return 1;
+    }
+    // CUDA: Start nvml
+    nvmlInit_v2();
+    // CUDA: Initialize number of GPUs and device handles
+    nvml_utils::init();
+
+    initialized = true;
+    return 0;
+}
+
+void power_meter::shutdown()
+{
+    if (!initialized)
+        return;
+    // The monitoring thread and the node readers read the cached MSR files
+    if (monitoring_thread.joinable())
+        stop_monitoring_loop();
+    rapl_utils::close_msr_files();
+    // CUDA: Stop nvml
+    nvmlShutdown();
+    initialized = false;
+}
+
+void power_meter::start_session(Session &session)
+{
+    rapl_utils::update_package_energy(session.cpu_start);
+    nvml_utils::update_gpu_energy(session.gpu_start);
+}
+
+void power_meter::stop_session(Session &session)
+{
+    // Read in reverse order, so that both sources measure an interval of similar length
+    nvml_utils::update_gpu_energy(session.gpu_stop);
+    rapl_utils::update_package_energy(session.cpu_stop);
+
+    rapl_utils::update_energy_data(session.cpu_results, session.cpu_start, session.cpu_stop);
+    nvml_utils::update_energy_data(session.gpu_results, session.gpu_start, session.gpu_stop);
+}
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include "trace_exporter.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <time.h>
+#include <unistd.h>
+
+// Global variable definitions
+namespace trace_exporter
+{
+    bool exporting{false};
+    std::ofstream trace_out;
+    // Readings are timestamped with CLOCK_REALTIME, this offset moves them to CLOCK_MONOTONIC
+    double realtime_to_monotonic_us{0};
+    // Every event but the first one is preceded by a separator
+    bool first_event{true};
+}
+
+/*
+Returns the difference between two timestamps in microseconds
+*/
+static double diff_us(const struct timespec &a, const struct timespec &b)
+{
+    return (double)(a.tv_sec - b.tv_sec) * 1E6 + (double)(a.tv_nsec - b.tv_nsec) / 1E3;
+}
+
+/*
+Writes a counter event. The value is plotted in a separate track for each name, and holds
+until the next event of the same track, so the average power of an interval is written
+with the timestamp of its start
+*/
+static void write_counter(const char *track, unsigned int index, const struct timespec &time, double watts)
+{
+    if (!trace_exporter::first_event)
+        trace_exporter::trace_out << ",\n";
+    trace_exporter::first_event = false;
+    trace_exporter::trace_out << "{\"name\":\"" << track << " " << index << " power\",\"ph\":\"C\",\"ts\":"
+                              << diff_us(time, {0, 0}) + trace_exporter::realtime_to_monotonic_us
+                              << ",\"pid\":" << getpid() << ",\"args\":{\"W\":" << watts << "}}";
+}
+
+double trace_exporter::get_realtime_to_monotonic_us()
+{
+    struct timespec realtime, monotonic;
+    clock_gettime(CLOCK_REALTIME, &realtime);
+    clock_gettime(CLOCK_MONOTONIC, &monotonic);
+    return diff_us(monotonic, realtime);
+}
+
+void trace_exporter::open(const std::filesystem::path &filename, double clock_offset_us)
+{
+    realtime_to_monotonic_us = clock_offset_us;
+
+    trace_out.open(filename);
+    // Microsecond timestamps need more digits than the default precision
+    trace_out.setf(std::ios::fixed);
+    trace_out.precision(3);
+    trace_out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    first_event = true;
+    // Name the process the counter tracks belong to
+    trace_out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << getpid()
+              << ",\"args\":{\"name\":\"Power meter\"}}";
+    first_event = false;
+    exporting = true;
+    printf("POWER METER: Exporting Chrome trace to %s\n", filename.c_str());
+}
+
+void trace_exporter::close()
+{
+    exporting = false;
+    trace_out << "\n]}\n";
+    trace_out.close();
+}
+
+void trace_exporter::write_cpu_power(const rapl_utils::EnergyAux &previous_data, const rapl_utils::EnergyAux &current_data)
+{
+    double time_diff = diff_us(current_data.time, previous_data.time) / 1E6;
+    // Power is undefined for an empty interval, and nan or inf would make the JSON invalid
+    if (time_diff <= 0)
+        return;
+    for (int i = 0; i < rapl_utils::numa_nodes; i++)
+    {
+        float energy_diff = rapl_utils::get_node_energy_diff(current_data.energy[i], previous_data.energy[i]);
+        write_counter("CPU node", i, previous_data.time, energy_diff / time_diff);
+    }
+}
+
+void trace_exporter::write_gpu_power(const nvml_utils::EnergyAux &previous_data, const nvml_utils::EnergyAux &current_data)
+{
+    double time_diff = diff_us(current_data.time, previous_data.time) / 1E6;
+    if (time_diff <= 0)
+        return;
+    for (unsigned int i = 0; i < nvml_utils::num_GPUs; i++)
+    {
+        write_counter("GPU", i, previous_data.time, (current_data.energy[i] - previous_data.energy[i]) / time_diff);
+    }
+}
+
+void trace_exporter::write_gpu_power_sample(unsigned int gpu, const nvml_utils::PowerSample &sample)
+{
+    struct timespec time;
+    time.tv_sec = sample.timestamp / 1000000;
+    time.tv_nsec = (sample.timestamp % 1000000) * 1000;
+    write_counter("GPU", gpu, time, sample.power);
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include "work_counter.hh"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Global variable definitions
+namespace work_counter
+{
+    thread_local WorkSlot *thread_slot{nullptr};
+    // Slots are never freed, so that the work of exited threads is still accounted for
+    std::vector<std::unique_ptr<WorkSlot>> slots;
+    std::mutex slots_mutex;
+}
+
+work_counter::WorkSlot *work_counter::register_thread()
+{
+    std::lock_guard<std::mutex> lock(slots_mutex);
+    slots.push_back(std::make_unique<WorkSlot>());
+    thread_slot = slots.back().get();
+    return thread_slot;
+}
+
+unsigned long long work_counter::get_total_work()
+{
+    unsigned long long total{0};
+    std::lock_guard<std::mutex> lock(slots_mutex);
+    for (const auto &slot : slots)
+    {
+        total += slot->ops.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void work_counter::update_work(WorkAux &data)
+{
+    data.ops = get_total_work();
+}
+
+void work_counter::update_work_data(WorkData &output_data, const WorkAux &previous_data, const WorkAux &current_data,
+                                    double energy)
+{
+    output_data.ops = current_data.ops - previous_data.ops;
+    output_data.joules_per_op = output_data.ops > 0 ? energy / output_data.ops : 0;
+    // Throughput per Watt: (ops / s) / (J / s) = ops / J
+    output_data.ops_per_watt = energy > 0 ? output_data.ops / energy : 0;
+}
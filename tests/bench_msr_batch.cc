@@ -0,0 +1,65 @@
+#include "msr_batch_reader.hh"
+#include "msr_reader.hh"
+#include "rapl_const.hh"
+#include "fake_msr.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+using namespace rapl_utils;
+
+/*
+Compares reading the package energy MSR of many cores in io_uring batches against one pread per
+core, on fake MSR files. Usage: bench_msr_batch [cores] [batches]
+*/
+int main(int argc, char **argv)
+{
+    int num_cores = argc > 1 ? atoi(argv[1]) : 128;
+    int batches = argc > 2 ? atoi(argv[2]) : 20000;
+    unsigned int address = RAPL_REGISTER_ADDRESSES[INTEL][PKG_ENERGY_STATUS];
+
+    auto msr_dir = std::filesystem::temp_directory_path() / "power_meter_bench_msr_batch";
+    fake_msr::create(msr_dir, num_cores);
+    auto cores = std::make_unique<int[]>(num_cores);
+    for (int i = 0; i < num_cores; ++i)
+    {
+        cores[i] = i;
+        fake_msr::write(msr_dir, i, address, i * 1000 + 7);
+    }
+    set_msr_dir(msr_dir);
+    init_msr_batch(cores.get(), num_cores);
+
+    auto values = std::make_unique<unsigned long long[]>(num_cores);
+    int status = 0;
+    bool uring_available = msr_batch_uring;
+    for (bool uring : {true, false})
+    {
+        if (uring && !uring_available)
+            continue;
+        msr_batch_uring = uring;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < batches; ++i)
+        {
+            read_msr_batch(address, values.get());
+        }
+        auto end = std::chrono::steady_clock::now();
+
+        for (int i = 0; i < num_cores; ++i)
+        {
+            if (values[i] != (unsigned long long)i * 1000 + 7)
+            {
+                fprintf(stderr, "Wrong value read from core %d: %llu\n", i, values[i]);
+                status = 1;
+            }
+        }
+        printf("%s: %.2f us per batch of %d cores\n", uring ? "io_uring" : "pread",
+               std::chrono::duration<double, std::micro>(end - start).count() / batches, num_cores);
+    }
+
+    close_msr_batch();
+    close_msr_files();
+    std::filesystem::remove_all(msr_dir);
+    return status;
+}
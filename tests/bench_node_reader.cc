@@ -0,0 +1,65 @@
+#include "node_reader.hh"
+#include "msr_reader.hh"
+#include "fake_msr.hh"
+
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+using namespace rapl_utils;
+
+/*
+Compares reading every node's package energy serially with update_package_energy() against the
+per-node readers, on fake MSR files. The topology is overridden to simulate the specified number
+of nodes, spread over the available cores. Usage: bench_node_reader [nodes] [samples]
+
+Fake MSR files are read without the cross-socket IPI of the msr driver, so this measures the
+synchronization overhead of the readers rather than the reads they parallelize
+*/
+int main(int argc, char **argv)
+{
+    int nodes = argc > 1 ? atoi(argv[1]) : MAX_NUMA_NODES;
+    int samples = argc > 2 ? atoi(argv[2]) : 20000;
+    int num_cores = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    auto msr_dir = std::filesystem::temp_directory_path() / "power_meter_bench_node_reader";
+    fake_msr::create(msr_dir, num_cores);
+    set_msr_dir(msr_dir);
+    if (init() != 0)
+        return 1;
+
+    numa_nodes = std::min(nodes, MAX_NUMA_NODES);
+    first_node_core = std::make_unique<int[]>(numa_nodes);
+    for (int i = 0; i < numa_nodes; ++i)
+    {
+        first_node_core[i] = i % num_cores;
+        cache_msr_file(first_node_core[i]);
+    }
+
+    EnergyAux data;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < samples; ++i)
+    {
+        update_package_energy(data);
+    }
+    auto end = std::chrono::steady_clock::now();
+    printf("serial: %.2f us per sample of %d nodes\n",
+           std::chrono::duration<double, std::micro>(end - start).count() / samples, numa_nodes);
+
+    start_node_readers();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < samples; ++i)
+    {
+        update_package_energy_parallel(data);
+    }
+    end = std::chrono::steady_clock::now();
+    stop_node_readers();
+    printf("parallel: %.2f us per sample of %d nodes on %d cores\n",
+           std::chrono::duration<double, std::micro>(end - start).count() / samples, numa_nodes, num_cores);
+
+    close_msr_files();
+    std::filesystem::remove_all(msr_dir);
+    return 0;
+}
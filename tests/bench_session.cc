@@ -0,0 +1,44 @@
+#include "session.hh"
+#include "msr_reader.hh"
+#include "fake_msr.hh"
+
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+/*
+Measures the cost of a start_session() and stop_session() pair, reading fake MSR files and the
+stub NVML. This is the overhead added by the power meter around every measured region, without
+the cost of the msr driver and the NVML calls themselves
+*/
+int main(int argc, char **argv)
+{
+    int sessions = argc > 1 ? atoi(argv[1]) : 100000;
+
+    auto msr_dir = std::filesystem::temp_directory_path() / "power_meter_bench_session";
+    fake_msr::create(msr_dir, (int)sysconf(_SC_NPROCESSORS_CONF));
+    rapl_utils::set_msr_dir(msr_dir);
+
+    auto init_start = std::chrono::steady_clock::now();
+    if (power_meter::init() != 0)
+        return 1;
+    auto init_end = std::chrono::steady_clock::now();
+
+    power_meter::Session session;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < sessions; ++i)
+    {
+        power_meter::start_session(session);
+        power_meter::stop_session(session);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    printf("init: %.1f us\n", std::chrono::duration<double, std::micro>(init_end - init_start).count());
+    printf("start_session + stop_session: %.3f us over %d sessions\n",
+           std::chrono::duration<double, std::micro>(end - start).count() / sessions, sessions);
+
+    power_meter::shutdown();
+    std::filesystem::remove_all(msr_dir);
+    return 0;
+}
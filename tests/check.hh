@@ -0,0 +1,17 @@
+#ifndef CHECK_HH
+#define CHECK_HH
+
+#include <cmath>
+#include <cstdio>
+
+// Minimal assertions for the tests, each test function returns the number of failed checks (0 or 1)
+#define CHECK(condition)                                                              \
+    if (!(condition))                                                                 \
+    {                                                                                 \
+        fprintf(stderr, "%s:%d: Check failed: %s\n", __FILE__, __LINE__, #condition); \
+        return 1;                                                                     \
+    }
+
+#define CHECK_NEAR(value, expected) CHECK(std::fabs((value) - (expected)) < 1E-9)
+
+#endif
@@ -0,0 +1,40 @@
+#include "fake_msr.hh"
+#include "rapl_const.hh"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdexcept>
+#include <string>
+
+using namespace rapl_utils;
+
+// Power units of 1/8 W, energy units of 1/2^14 J and time units of 1/2^10 s
+#define FAKE_POWER_UNIT 0xA0E03ULL
+
+void fake_msr::create(const std::filesystem::path &dir, int num_cores)
+{
+  for (int core = 0; core < num_cores; ++core)
+  {
+    std::filesystem::create_directories(dir / std::to_string(core));
+    for (int vendor = 0; vendor < NUM_VENDORS; ++vendor)
+    {
+      write(dir, core, RAPL_REGISTER_ADDRESSES[vendor][RAPL_POWER_UNIT], FAKE_POWER_UNIT);
+      write(dir, core, RAPL_REGISTER_ADDRESSES[vendor][PKG_ENERGY_STATUS], 0);
+      write(dir, core, RAPL_REGISTER_ADDRESSES[vendor][CORE_ENERGY_STATUS], 0);
+    }
+  }
+}
+
+void fake_msr::write(const std::filesystem::path &dir, int core, unsigned int address, unsigned long long value)
+{
+  auto filename = dir / std::to_string(core) / "msr";
+  // The file is sparse, only the blocks holding the written registers take space
+  int fd = open(filename.c_str(), O_WRONLY | O_CREAT, 0644);
+  if (fd < 0 || pwrite(fd, &value, 8, address) != 8)
+  {
+    if (fd >= 0)
+      close(fd);
+    throw std::runtime_error("Could not write fake MSR file " + filename.string());
+  }
+  close(fd);
+}
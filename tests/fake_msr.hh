@@ -0,0 +1,21 @@
+#ifndef FAKE_MSR_HH
+#define FAKE_MSR_HH
+
+#include <filesystem>
+
+// Regular files standing in for the msr driver, to be read through rapl_utils::set_msr_dir()
+namespace fake_msr
+{
+    /*
+    Create [dir]/[core]/msr for the specified number of cores, with the RAPL power unit
+    registers of both vendors set and every energy counter at 0
+    */
+    void create(const std::filesystem::path &dir, int num_cores);
+
+    /*
+    Set the MSR at the specified address of the specified core
+    */
+    void write(const std::filesystem::path &dir, int core, unsigned int address, unsigned long long value);
+}
+
+#endif
@@ -0,0 +1,72 @@
+#include "nvml_stub.hh"
+
+// Global variable definitions
+namespace nvml_stub
+{
+    unsigned int device_count{1};
+    unsigned long long total_energy{0};
+    std::vector<nvmlSample_t> samples;
+    nvmlValueType_t samples_value_type{NVML_VALUE_TYPE_UNSIGNED_INT};
+    nvmlReturn_t samples_error{NVML_SUCCESS};
+    unsigned int samples_error_calls{0};
+}
+
+nvmlReturn_t nvmlInit_v2()
+{
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlShutdown()
+{
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetCount_v2(unsigned int *deviceCount)
+{
+    *deviceCount = nvml_stub::device_count;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetHandleByIndex_v2(unsigned int index, nvmlDevice_t *device)
+{
+    if (index >= nvml_stub::device_count)
+        return NVML_ERROR_INVALID_ARGUMENT;
+    *device = nullptr;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetTotalEnergyConsumption(nvmlDevice_t device, unsigned long long *energy)
+{
+    *energy = nvml_stub::total_energy;
+    return NVML_SUCCESS;
+}
+
+nvmlReturn_t nvmlDeviceGetSamples(nvmlDevice_t device, nvmlSamplingType_t type, unsigned long long lastSeenTimeStamp,
+                                  nvmlValueType_t *sampleValType, unsigned int *sampleCount, nvmlSample_t *samples)
+{
+    if (nvml_stub::samples_error_calls > 0)
+    {
+        nvml_stub::samples_error_calls--;
+        return nvml_stub::samples_error;
+    }
+
+    unsigned int count{0};
+    for (const auto &sample : nvml_stub::samples)
+    {
+        if (sample.timeStamp <= lastSeenTimeStamp)
+            continue;
+        // Without a buffer only the number of samples is returned
+        if (samples)
+        {
+            if (count == *sampleCount)
+                break;
+            samples[count] = sample;
+        }
+        ++count;
+    }
+    if (count == 0)
+        return NVML_ERROR_NOT_FOUND;
+    *sampleValType = nvml_stub::samples_value_type;
+    *sampleCount = count;
+    return NVML_SUCCESS;
+}
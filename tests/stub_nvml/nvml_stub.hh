@@ -0,0 +1,22 @@
+#ifndef NVML_STUB_HH
+#define NVML_STUB_HH
+
+#include <vector>
+#include <nvml.h>
+
+// State returned by the stub NVML, set by the tests
+namespace nvml_stub
+{
+    extern unsigned int device_count;
+    // Energy counter of every device, in mili Joules
+    extern unsigned long long total_energy;
+    // Power samples kept by the driver, nvmlDeviceGetSamples() returns those newer than the
+    // timestamp it is passed, or NVML_ERROR_NOT_FOUND if there are none
+    extern std::vector<nvmlSample_t> samples;
+    extern nvmlValueType_t samples_value_type;
+    // Returned by the next samples_error_calls calls to nvmlDeviceGetSamples() instead
+    extern nvmlReturn_t samples_error;
+    extern unsigned int samples_error_calls;
+}
+
+#endif
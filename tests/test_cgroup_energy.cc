@@ -0,0 +1,133 @@
+#include "cgroup_energy.hh"
+#include "check.hh"
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+
+using namespace cgroup_energy;
+
+static std::filesystem::path cgroup_dir;
+
+/*
+Writes a synthetic cpu.stat for the specified cgroup, with usage_usec after another key
+*/
+static void write_cpu_stat(const std::string &cgroup, unsigned long long usage_usec)
+{
+    std::filesystem::create_directories(cgroup_dir / cgroup);
+    std::ofstream(cgroup_dir / cgroup / "cpu.stat") << "nr_periods 0\n"
+                                                    << "usage_usec " << usage_usec << "\n"
+                                                    << "user_usec " << usage_usec / 2 << "\n";
+}
+
+/*
+Reads both cgroups one second apart, having used the specified CPU time in between
+*/
+static void measure(CgroupData &output_data, unsigned long long usage_a, unsigned long long usage_b,
+                    double energy, int num_cpus)
+{
+    CgroupAux previous_data, current_data;
+    write_cpu_stat("a", 1000);
+    write_cpu_stat("b", 2000);
+    update_cgroup_usage(previous_data);
+    previous_data.time = {10, 0};
+    write_cpu_stat("a", 1000 + usage_a);
+    write_cpu_stat("b", 2000 + usage_b);
+    update_cgroup_usage(current_data);
+    current_data.time = {11, 0};
+    update_cgroup_data(output_data, previous_data, current_data, energy, num_cpus);
+}
+
+static int test_usage_parsing()
+{
+    write_cpu_stat("a", 123456);
+    CHECK(get_cgroup_usage("a") == 123456);
+    // Missing cgroups count as idle
+    CHECK(get_cgroup_usage("missing") == 0);
+    return 0;
+}
+
+static int test_proportional_split()
+{
+    // A quarter and an eighth of 4 CPUs during one second
+    CgroupData data;
+    measure(data, 1000000, 500000, 100, 4);
+    CHECK_NEAR(data.energy[0], 25);
+    CHECK_NEAR(data.energy[1], 12.5);
+    CHECK_NEAR(data.power[0], 25);
+    CHECK_NEAR(data.unattributed_energy, 62.5);
+    CHECK_NEAR(data.unattributed_power, 62.5);
+
+    // The total energy accumulates over intervals
+    measure(data, 1000000, 500000, 100, 4);
+    CHECK_NEAR(data.total_energy[0], 50);
+    CHECK_NEAR(data.total_energy[1], 25);
+    return 0;
+}
+
+static int test_oversubscribed_shares()
+{
+    // Sampling skew: the cgroups report 150% of the machine, split the energy as 3:1
+    CgroupData data;
+    measure(data, 4500000, 1500000, 100, 4);
+    CHECK_NEAR(data.energy[0], 75);
+    CHECK_NEAR(data.energy[1], 25);
+    CHECK_NEAR(data.unattributed_energy, 0);
+
+    // Equal usage gets equal energy regardless of the order cgroups are read in
+    measure(data, 3000000, 3000000, 100, 4);
+    CHECK_NEAR(data.energy[0], 50);
+    CHECK_NEAR(data.energy[1], 50);
+    return 0;
+}
+
+static int test_recreated_cgroup()
+{
+    // Usage drops when a cgroup is recreated, it is idle for that interval
+    CgroupAux previous_data, current_data;
+    write_cpu_stat("a", 5000000);
+    write_cpu_stat("b", 0);
+    update_cgroup_usage(previous_data);
+    previous_data.time = {10, 0};
+    write_cpu_stat("a", 1000);
+    write_cpu_stat("b", 1000000);
+    update_cgroup_usage(current_data);
+    current_data.time = {11, 0};
+
+    CgroupData data;
+    update_cgroup_data(data, previous_data, current_data, 100, 2);
+    CHECK_NEAR(data.energy[0], 0);
+    CHECK_NEAR(data.energy[1], 50);
+    CHECK_NEAR(data.unattributed_energy, 50);
+    return 0;
+}
+
+static int test_overlapping_cgroups()
+{
+    // Nested in, containing or the same as a monitored cgroup
+    CHECK(add_cgroup("a/child") != 0);
+    CHECK(add_cgroup("/a/") != 0);
+    CHECK(add_cgroup("./b") != 0);
+    CHECK(add_cgroup("/") != 0);
+    CHECK(cgroups.size() == 2);
+    // Sharing a prefix is not nesting
+    CHECK(add_cgroup("/ab/child") == 0);
+    CHECK(cgroups.back() == "ab/child");
+    CHECK(add_cgroup("ab") != 0);
+    return 0;
+}
+
+int main()
+{
+    cgroup_dir = std::filesystem::temp_directory_path() / "power_meter_test_cgroup_energy";
+    std::filesystem::remove_all(cgroup_dir);
+    set_cgroup_root(cgroup_dir);
+    add_cgroup("a");
+    add_cgroup("b");
+
+    int failures = test_usage_parsing() + test_proportional_split() + test_oversubscribed_shares() +
+                   test_recreated_cgroup() + test_overlapping_cgroups();
+
+    std::filesystem::remove_all(cgroup_dir);
+    return failures;
+}
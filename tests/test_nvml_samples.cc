@@ -0,0 +1,146 @@
+#include "power_meter.hh"
+#include "nvml_utils.hh"
+#include "msr_reader.hh"
+#include "session.hh"
+#include "nvml_stub.hh"
+#include "fake_msr.hh"
+#include "check.hh"
+
+#include <unistd.h>
+#include <limits.h>
+#include <time.h>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <thread>
+
+static unsigned long long now_us()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    return (unsigned long long)now.tv_sec * 1000000 + now.tv_nsec / 1000;
+}
+
+static nvmlSample_t power_sample(unsigned long long timestamp, unsigned int milliwatts)
+{
+    nvmlSample_t sample;
+    sample.timeStamp = timestamp;
+    sample.sampleValue.uiVal = milliwatts;
+    return sample;
+}
+
+/*
+Only the samples newer than the last one retrieved are returned, converted to Watts
+*/
+static int test_timestamp_filtering()
+{
+    unsigned long long start = now_us();
+    // Taken before the samples were reset, never returned
+    nvml_stub::samples = {power_sample(start - 2000, 100000), power_sample(start - 1000, 110000)};
+    nvml_utils::reset_power_samples();
+    nvml_stub::samples.push_back(power_sample(start + 1000000, 120000));
+    nvml_stub::samples.push_back(power_sample(start + 2000000, 130000));
+
+    std::vector<nvml_utils::PowerSample> samples;
+    CHECK(nvml_utils::get_power_samples(0, samples) == NVML_SUCCESS);
+    CHECK(samples.size() == 2);
+    CHECK(samples[0].timestamp == start + 1000000);
+    CHECK(samples[0].power == 120);
+    CHECK(samples[1].power == 130);
+
+    // NVML_ERROR_NOT_FOUND: no new samples since the last call
+    CHECK(nvml_utils::get_power_samples(0, samples) == NVML_SUCCESS);
+    CHECK(samples.empty());
+
+    nvml_stub::samples.push_back(power_sample(start + 3000000, 140000));
+    CHECK(nvml_utils::get_power_samples(0, samples) == NVML_SUCCESS);
+    CHECK(samples.size() == 1);
+    CHECK(samples[0].power == 140);
+    return 0;
+}
+
+/*
+Runs a short monitoring loop with power samples enabled and returns the lines of the samples file
+*/
+static std::vector<std::string> run_loop(const std::filesystem::path &output_dir)
+{
+    power_meter::gpu_power_samples = true;
+    power_meter::launch_monitoring_loop(10);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    power_meter::stop_monitoring_loop();
+
+    std::ifstream samples_file(output_dir / "gpu_samples");
+    std::string line;
+    std::vector<std::string> lines;
+    while (std::getline(samples_file, line))
+        lines.push_back(line);
+    return lines;
+}
+
+/*
+Samples kept by the driver before a monitoring loop is launched are not written
+*/
+static int test_reset_on_launch(const std::filesystem::path &output_dir)
+{
+    unsigned long long start = now_us();
+    nvml_stub::samples = {power_sample(start - 1000, 100000), power_sample(start + 1000000, 150000)};
+    auto lines = run_loop(output_dir);
+    // Header and the sample taken after the launch
+    CHECK(lines.size() == 2);
+    CHECK(lines[1].find(",0,150") != std::string::npos);
+    return 0;
+}
+
+/*
+Other errors only skip the GPU for the interval they happen in
+*/
+static int test_transient_error(const std::filesystem::path &output_dir)
+{
+    nvml_stub::samples = {power_sample(now_us() + 1000000, 150000)};
+    nvml_stub::samples_error = NVML_ERROR_UNKNOWN;
+    nvml_stub::samples_error_calls = 1;
+    auto lines = run_loop(output_dir);
+    CHECK(lines.size() == 2);
+    CHECK(power_meter::gpu_power_samples);
+    return 0;
+}
+
+/*
+GPUs without power samples fall back to polling the energy counter, for the current loop only
+*/
+static int test_not_supported_fallback(const std::filesystem::path &output_dir)
+{
+    nvml_stub::samples = {power_sample(now_us() + 1000000, 150000)};
+    nvml_stub::samples_error = NVML_ERROR_NOT_SUPPORTED;
+    nvml_stub::samples_error_calls = UINT_MAX;
+    std::vector<nvml_utils::PowerSample> samples;
+    CHECK(nvml_utils::get_power_samples(0, samples) == NVML_ERROR_NOT_SUPPORTED);
+
+    auto lines = run_loop(output_dir);
+    CHECK(lines.size() == 1);
+    // The setting is kept, a later loop harvests the samples again
+    CHECK(power_meter::gpu_power_samples);
+    nvml_stub::samples_error_calls = 0;
+    lines = run_loop(output_dir);
+    CHECK(lines.size() == 2);
+    return 0;
+}
+
+int main()
+{
+    auto test_dir = std::filesystem::temp_directory_path() / "power_meter_test_nvml_samples";
+    fake_msr::create(test_dir / "msr", (int)sysconf(_SC_NPROCESSORS_CONF));
+    rapl_utils::set_msr_dir(test_dir / "msr");
+    power_meter::output_dir = test_dir / "out";
+    if (power_meter::init() != 0)
+        return 1;
+
+    int failures = test_timestamp_filtering() + test_reset_on_launch(power_meter::output_dir) +
+                   test_transient_error(power_meter::output_dir) +
+                   test_not_supported_fallback(power_meter::output_dir);
+
+    power_meter::shutdown();
+    std::filesystem::remove_all(test_dir);
+    return failures;
+}